@@ -0,0 +1,267 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_ASYNC_LOGGER_H_
+#define ELOG_ASYNC_LOGGER_H_
+
+#include "config.h"
+
+#include <cstddef>
+#include <string>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include "atomic.h"
+#include "bounded_queue.h"
+#include "logger.h"
+#include "thread.h"
+#include "type_info.h"
+#include "util.h"
+
+namespace LOG {
+
+enum OverflowPolicy {
+  BLOCK_ON_OVERFLOW,
+  DROP_NEWEST_ON_OVERFLOW,
+  DROP_OLDEST_ON_OVERFLOW
+};
+
+// Logger which hands messages over to a background thread through a bounded
+// lock-free queue, so that the logging thread never waits for the I/O of the
+// underlying logger. FATAL and CHECK messages are written synchronously after
+// all the queued messages are flushed.
+class AsyncLogger : public Logger, Noncopyable {
+ public:
+  static const std::size_t kDefaultCapacity = 8192;
+
+  explicit AsyncLogger(Logger& logger,
+                       std::size_t capacity = kDefaultCapacity,
+                       OverflowPolicy overflow_policy = BLOCK_ON_OVERFLOW)
+      : logger_(logger),
+        queue_(capacity),
+        overflow_policy_(overflow_policy),
+        dropped_count_(0),
+        written_position_(0),
+        is_stopped_(false) {
+    thread_.set_thread_body(std::tr1::bind(&AsyncLogger::DrainQueue, this));
+    thread_.Run();
+  }
+
+  // Writes all the queued messages before returning.
+  virtual ~AsyncLogger() {
+    is_stopped_ = true;
+    thread_.Join();
+  }
+
+  OverflowPolicy overflow_policy() const {
+    return overflow_policy_;
+  }
+
+  void set_overflow_policy(OverflowPolicy overflow_policy) {
+    overflow_policy_ = overflow_policy;
+  }
+
+  // Number of messages discarded by DROP_NEWEST_ON_OVERFLOW or
+  // DROP_OLDEST_ON_OVERFLOW.
+  std::size_t dropped_count() const {
+    return dropped_count_;
+  }
+
+  // Waits until all the messages pushed before the call are written to the
+  // underlying logger or dropped. Later messages do not delay the return.
+  void Flush() {
+    const std::size_t position = queue_.enqueue_position();
+    while (static_cast<std::ptrdiff_t>(written_position_ - position) < 0) {
+      YieldThread();
+    }
+    AtomicFence();
+  }
+
+  virtual int GetTypeVerbosity(TypeInfo type_info) const {
+    return logger_.GetTypeVerbosity(type_info);
+  }
+
+  virtual void PushRawMessage(LogLevel level, const std::string& message) {
+    if (!IsLevelEnabled(level)) return;
+    Record record;
+    record.kind = Record::RAW;
+    record.level = level;
+    record.message = message;
+    Push(record);
+  }
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const std::string& message) {
+    PushMessage(level, source_file_name, line_number,
+                message.data(), message.size());
+  }
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const char* message,
+                           std::size_t message_size) {
+    if (!IsLevelEnabled(level)) return;
+    Record record;
+    record.kind = Record::GENERAL;
+    record.level = level;
+    record.source_file_name = source_file_name;
+    record.line_number = line_number;
+    record.message.assign(message, message_size);
+    Push(record);
+  }
+
+  virtual void PushFatalMessageAndThrow(const char* source_file_name,
+                                        int line_number,
+                                        const std::string& message) {
+    Flush();
+    logger_.PushFatalMessageAndThrow(source_file_name, line_number, message);
+    throw FatalLogError();
+  }
+
+  virtual void PushCheckMessageAndThrow(const char* source_file_name,
+                                        int line_number,
+                                        const std::string& message) {
+    Flush();
+    logger_.PushCheckMessageAndThrow(source_file_name, line_number, message);
+    throw CheckError();
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const std::string& message) {
+    PushTypedMessage(type_info, verbosity, source_file_name, line_number,
+                     message.data(), message.size());
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const char* message,
+                                std::size_t message_size) {
+    Record record;
+    record.kind = Record::TYPED;
+    record.type_info = type_info;
+    record.verbosity = verbosity;
+    record.source_file_name = source_file_name;
+    record.line_number = line_number;
+    record.message.assign(message, message_size);
+    Push(record);
+  }
+
+ private:
+  struct Record {
+    enum Kind {
+      RAW,
+      GENERAL,
+      TYPED
+    };
+
+    Record()
+        : kind(RAW),
+          level(INFO),
+          type_info(Type<void>()),
+          verbosity(0),
+          source_file_name(""),
+          line_number(0) {
+    }
+
+    Kind kind;
+    LogLevel level;
+    TypeInfo type_info;
+    int verbosity;
+    const char* source_file_name;
+    int line_number;
+    std::string message;
+  };
+
+  void Push(Record& record) {
+    switch (overflow_policy_) {
+      case BLOCK_ON_OVERFLOW:
+        while (!queue_.TryPush(record)) {
+          YieldThread();
+        }
+        break;
+      case DROP_NEWEST_ON_OVERFLOW:
+        if (!queue_.TryPush(record)) {
+          FetchAndAdd(dropped_count_, 1);
+        }
+        break;
+      case DROP_OLDEST_ON_OVERFLOW:
+        while (!queue_.TryPush(record)) {
+          Record oldest;
+          if (queue_.TryPop(oldest)) {
+            FetchAndAdd(dropped_count_, 1);
+          }
+        }
+        break;
+    }
+  }
+
+  void DrainQueue() {
+    static const int kSpinCount = 64;
+
+    Record record;
+    int idle_count = 0;
+    for (;;) {
+      std::size_t position;
+      if (queue_.TryPop(record, position)) {
+        Write(record);
+        AtomicFence();
+        written_position_ = position + 1;
+        idle_count = 0;
+        continue;
+      }
+      // Nothing is being written; the positions before were written here or
+      // dropped by DROP_OLDEST_ON_OVERFLOW.
+      AtomicFence();
+      if (static_cast<std::ptrdiff_t>(position - written_position_) > 0) {
+        written_position_ = position;
+      }
+
+      if (is_stopped_) break;
+      if (idle_count < kSpinCount) {
+        ++idle_count;
+        YieldThread();
+      } else {
+        SleepMilliSec(1);
+      }
+    }
+  }
+
+  void Write(const Record& record) {
+    switch (record.kind) {
+      case Record::RAW:
+        logger_.PushRawMessage(record.level, record.message);
+        break;
+      case Record::GENERAL:
+        logger_.PushMessage(record.level, record.source_file_name,
+                            record.line_number, record.message);
+        break;
+      case Record::TYPED:
+        logger_.PushTypedMessage(record.type_info, record.verbosity,
+                                 record.source_file_name, record.line_number,
+                                 record.message);
+        break;
+    }
+  }
+
+  Logger& logger_;
+  BoundedQueue<Record> queue_;
+  volatile OverflowPolicy overflow_policy_;
+  volatile std::size_t dropped_count_;
+  volatile std::size_t written_position_;  // written or dropped before it
+  volatile bool is_stopped_;
+  Thread thread_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_ASYNC_LOGGER_H_
@@ -0,0 +1,273 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include "config.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include <gtest/gtest.h>
+#include "async_logger.h"
+#include "stream_logger.h"
+#include "thread.h"
+
+namespace LOG {
+
+namespace {
+
+const char* kSourceFileName = "source file name";
+const int kLineNumber = 10;
+
+class SomeModule {};
+
+// Logger which blocks in PushMessage until released, so that tests can fill
+// up the queue of AsyncLogger.
+class BlockingLogger : public Logger {
+ public:
+  BlockingLogger()
+      : is_entered_(false),
+        is_released_(false) {
+  }
+
+  const std::vector<std::string>& messages() const {
+    return messages_;
+  }
+
+  void WaitUntilEntered() const {
+    while (!is_entered_) {
+      YieldThread();
+    }
+  }
+
+  void Release() {
+    is_released_ = true;
+  }
+
+  virtual void PushRawMessage(LogLevel, const std::string& message) {
+    messages_.push_back(message);
+  }
+
+  virtual void PushMessage(LogLevel,
+                           const char*,
+                           int,
+                           const std::string& message) {
+    is_entered_ = true;
+    while (!is_released_) {
+      YieldThread();
+    }
+    messages_.push_back(message);
+  }
+
+  virtual void PushFatalMessageAndThrow(const char*,
+                                        int,
+                                        const std::string&) {
+    throw FatalLogError();
+  }
+
+  virtual void PushCheckMessageAndThrow(const char*,
+                                        int,
+                                        const std::string&) {
+    throw CheckError();
+  }
+
+  virtual void PushTypedMessage(TypeInfo,
+                                int,
+                                const char*,
+                                int,
+                                const std::string& message) {
+    messages_.push_back(message);
+  }
+
+ private:
+  std::vector<std::string> messages_;
+  volatile bool is_entered_;
+  volatile bool is_released_;
+};
+
+void PushMessages(AsyncLogger* logger, int count) {
+  for (int i = 0; i < count; ++i) {
+    logger->PushMessage(INFO, kSourceFileName, kLineNumber, "message");
+  }
+}
+
+void PushMessagesUntilStopped(AsyncLogger* logger, volatile bool* is_stopped) {
+  while (!*is_stopped) {
+    logger->PushMessage(INFO, kSourceFileName, kLineNumber, "message");
+  }
+}
+
+std::size_t CountLines(const std::string& text) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') ++count;
+  }
+  return count;
+}
+
+// Pushes "0", "1", ... and returns after the first one is held by the sink.
+void FillQueue(BlockingLogger& sink, AsyncLogger& logger, int count) {
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber, "0");
+  sink.WaitUntilEntered();
+  for (int i = 1; i < count; ++i) {
+    std::ostringstream message;
+    message << i;
+    logger.PushMessage(INFO, kSourceFileName, kLineNumber, message.str());
+  }
+}
+
+}  // anonymous namespace
+
+TEST(AsyncLoggerTest, PushMessage) {
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger);
+
+  logger.PushMessage(WARN, kSourceFileName, kLineNumber, "message");
+  logger.Flush();
+
+  EXPECT_NE(std::string::npos, stream.str().find("[WARN]"));
+  EXPECT_NE(std::string::npos, stream.str().find("message"));
+}
+
+TEST(AsyncLoggerTest, PushTypedMessage) {
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger);
+
+  const TypeInfo type_info((Type<SomeModule>()));
+  logger.PushTypedMessage(type_info, 0, kSourceFileName, kLineNumber, "typed");
+  logger.Flush();
+
+  EXPECT_NE(std::string::npos, stream.str().find("SomeModule"));
+  EXPECT_NE(std::string::npos, stream.str().find("typed"));
+}
+
+TEST(AsyncLoggerTest, DestructorFlushes) {
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  {
+    AsyncLogger logger(stream_logger);
+    PushMessages(&logger, 100);
+  }
+  EXPECT_EQ(100u, CountLines(stream.str()));
+}
+
+TEST(AsyncLoggerTest, MultipleProducers) {
+  static const int kNumThreads = 4;
+  static const int kNumMessages = 1000;
+
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger, 16);
+
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(PushMessages, &logger, kNumMessages)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  logger.Flush();
+
+  EXPECT_EQ(0u, logger.dropped_count());
+  EXPECT_EQ(static_cast<std::size_t>(kNumThreads * kNumMessages),
+            CountLines(stream.str()));
+}
+
+TEST(AsyncLoggerTest, FlushReturnsUnderSustainedLoad) {
+  static const int kNumThreads = 4;
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger, 16);
+
+  volatile bool is_stopped = false;
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(PushMessagesUntilStopped, &logger, &is_stopped)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < 100; ++i) {
+    logger.PushMessage(INFO, kSourceFileName, kLineNumber, "flushed");
+    logger.Flush();
+  }
+  is_stopped = true;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  logger.Flush();
+  EXPECT_NE(std::string::npos, stream.str().find("flushed"));
+}
+
+TEST(AsyncLoggerTest, DropNewestOnOverflow) {
+  BlockingLogger sink;
+  AsyncLogger logger(sink, 2, DROP_NEWEST_ON_OVERFLOW);
+
+  FillQueue(sink, logger, 6);
+  EXPECT_EQ(3u, logger.dropped_count());
+
+  sink.Release();
+  logger.Flush();
+  ASSERT_EQ(3u, sink.messages().size());
+  EXPECT_EQ("0", sink.messages()[0]);
+  EXPECT_EQ("1", sink.messages()[1]);
+  EXPECT_EQ("2", sink.messages()[2]);
+}
+
+TEST(AsyncLoggerTest, DropOldestOnOverflow) {
+  BlockingLogger sink;
+  AsyncLogger logger(sink, 2, DROP_OLDEST_ON_OVERFLOW);
+
+  FillQueue(sink, logger, 6);
+  EXPECT_EQ(3u, logger.dropped_count());
+
+  sink.Release();
+  logger.Flush();
+  ASSERT_EQ(3u, sink.messages().size());
+  EXPECT_EQ("0", sink.messages()[0]);
+  EXPECT_EQ("4", sink.messages()[1]);
+  EXPECT_EQ("5", sink.messages()[2]);
+}
+
+TEST(AsyncLoggerTest, FatalFlushesBeforeThrow) {
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger);
+
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber, "first");
+  EXPECT_THROW(
+      logger.PushFatalMessageAndThrow(kSourceFileName, kLineNumber, "fatal"),
+      FatalLogError);
+
+  const std::string message = stream.str();
+  const std::size_t first_position = message.find("first");
+  ASSERT_NE(std::string::npos, first_position);
+  EXPECT_LT(first_position, message.find("[FATAL]"));
+}
+
+TEST(AsyncLoggerTest, CheckFlushesBeforeThrow) {
+  std::ostringstream stream;
+  StreamLogger stream_logger(stream);
+  AsyncLogger logger(stream_logger);
+
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber, "first");
+  EXPECT_THROW(
+      logger.PushCheckMessageAndThrow(kSourceFileName, kLineNumber, "check"),
+      CheckError);
+
+  const std::string message = stream.str();
+  const std::size_t first_position = message.find("first");
+  ASSERT_NE(std::string::npos, first_position);
+  EXPECT_LT(first_position, message.find("[CHECK]"));
+}
+
+}  // namespace LOG
@@ -15,6 +15,8 @@
 # error eLog does not support g++ < 4.01
 #endif
 
+#include <cstddef>
+
 namespace LOG {
 
 // TODO(S.Tokui): Write unittest.
@@ -41,6 +43,50 @@ inline void* CompareAndSwap(T* volatile& val, T* oldval, T* newval) {
 #endif
 }
 
+inline std::size_t CompareAndSwap(volatile std::size_t& val,
+                                  std::size_t oldval,
+                                  std::size_t newval) {
+#if defined(_WIN64)
+  return InterlockedCompareExchange64(
+      reinterpret_cast<volatile LONGLONG*>(&val), newval, oldval);
+#elif defined(_WIN32)
+  return InterlockedCompareExchange(
+      reinterpret_cast<volatile LONG*>(&val), newval, oldval);
+#elif defined(ELOG_I_ATOMIC_CAS_USE_MACOSX_OSATOMIC)
+  return OSAtomicCompareAndSwapLongBarrier(
+      oldval, newval, reinterpret_cast<volatile long*>(&val)) ? oldval : val;
+#elif defined(ELOG_I_ATOMIC_CAS_USE_GNUC_EXTENSION)
+  return __sync_val_compare_and_swap(&val, oldval, newval);
+#endif
+}
+
+// Adds delta to val and returns the value held before the addition.
+inline std::size_t FetchAndAdd(volatile std::size_t& val, std::size_t delta) {
+#if defined(_WIN64)
+  return InterlockedExchangeAdd64(
+      reinterpret_cast<volatile LONGLONG*>(&val), delta);
+#elif defined(_WIN32)
+  return InterlockedExchangeAdd(reinterpret_cast<volatile LONG*>(&val), delta);
+#elif defined(ELOG_I_ATOMIC_CAS_USE_MACOSX_OSATOMIC)
+  return OSAtomicAdd64Barrier(
+      delta, reinterpret_cast<volatile int64_t*>(&val)) - delta;
+#elif defined(ELOG_I_ATOMIC_CAS_USE_GNUC_EXTENSION)
+  return __sync_fetch_and_add(&val, delta);
+#endif
+}
+
+// Full memory barrier. Volatile accesses alone do not order stores against
+// later loads, so lock-free code publishing data must call this in between.
+inline void AtomicFence() {
+#ifdef _WIN32
+  MemoryBarrier();
+#elif defined(ELOG_I_ATOMIC_CAS_USE_MACOSX_OSATOMIC)
+  OSMemoryBarrier();
+#elif defined(ELOG_I_ATOMIC_CAS_USE_GNUC_EXTENSION)
+  __sync_synchronize();
+#endif
+}
+
 template <typename T>
 inline bool AtomicSetOnce(volatile T& val, T newval) {
   const T oldval = val;
@@ -61,6 +107,8 @@ static const OnceFlag ONCE_CALLED = 1;
 
 template <typename Function>
 inline void CallOnce(OnceFlag& once_flag, Function function) {
+  // Avoid the locked CAS once the function has been called.
+  if (once_flag != ONCE_INIT) return;
   if (CompareAndSwap(once_flag, ONCE_INIT, ONCE_CALLED) == ONCE_INIT) {
     function();
   }
@@ -4,33 +4,74 @@
 #ifndef ELOG_BENCHMARK_H_
 #define ELOG_BENCHMARK_H_
 
+#include "benchmark_runner.h"
+#include "benchmark_switch.h"
 #include "elog.h"
 #include "scoped_benchmark.h"
 #include "typed_benchmark.h"
 
 #define BENCHMARK(...) ELOG_I_OVERLOAD(ELOG_I_BENCHMARK_, __VA_ARGS__)
 
-#define ELOG_I_BENCHMARK_1(name) \
+#ifdef ELOG_DISABLE_BENCHMARK
+
+// The clauses are executed without any measurement.
+# define ELOG_I_BENCHMARK_1(name) \
+  if (::LOG::NullBenchmark name = ::LOG::NullBenchmark()); else
+# define ELOG_I_BENCHMARK_2(suite, name) ELOG_I_BENCHMARK_1(name)
+# define ELOG_I_BENCHMARK_3(type, verbosity, name) ELOG_I_BENCHMARK_1(name)
+# define ELOG_I_BENCHMARK_4(suite, type, verbosity, name) \
+  ELOG_I_BENCHMARK_1(name)
+
+#else  // ifndef ELOG_DISABLE_BENCHMARK
+
+// The scope is inactive if benchmarks are disabled, or if it only logs and
+// the messages would be discarded. The verbosity expression is evaluated more
+// than once.
+# define ELOG_I_BENCHMARK_1(name) \
   if (::LOG::ScopedBenchmark< ::LOG::INFO> name = \
+      ::LOG::IsBenchmarkEnabled() && \
+      ((::LOG::GeneralLog< ::LOG::INFO>::kIsCompiledIn && \
+        ::LOG::IsLogLevelEnabled< ::LOG::INFO>()) || \
+       ::LOG::IsBenchmarkTraceEnabled()) ? \
       ::LOG::ScopedBenchmark< ::LOG::INFO>(ELOG_I_STRINGIZE(name), \
-                                           ELOG_I_FILE, ELOG_I_LINE)); else
+                                           ELOG_I_FILE, ELOG_I_LINE) : \
+      ::LOG::ScopedBenchmark< ::LOG::INFO>()); else
 
-#define ELOG_I_BENCHMARK_2(suite, name) \
+# define ELOG_I_BENCHMARK_2(suite, name) \
   if (::LOG::ScopedBenchmark< ::LOG::INFO> name = \
-      ::LOG::ScopedBenchmark< ::LOG::INFO>(ELOG_I_STRINGIZE(name), \
-                                           ELOG_I_FILE, ELOG_I_LINE, \
-                                           &suite)); else
+      ::LOG::IsBenchmarkEnabled() ? \
+      ::LOG::ScopedBenchmark< ::LOG::INFO>( \
+          ELOG_I_STRINGIZE(name), ELOG_I_FILE, ELOG_I_LINE, &suite, NULL, \
+          &::LOG::BenchmarkCaseSiteHolder< \
+              ::LOG::TranslationUnitTag, ELOG_I_LINE>::site) : \
+      ::LOG::ScopedBenchmark< ::LOG::INFO>()); else
 
-#define ELOG_I_BENCHMARK_3(type, verbosity, name) \
+# define ELOG_I_BENCHMARK_3(type, verbosity, name) \
   if (::LOG::TypedBenchmark name = \
+      ::LOG::IsBenchmarkEnabled() && \
+      ((ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) && \
+        ::LOG::IsTypedLogEnabled( \
+            ::LOG::TypedLogSiteHolder<type, ::LOG::TranslationUnitTag, \
+                                      ELOG_I_LINE>::site, \
+            (verbosity), ELOG_I_FILE, ELOG_I_LINE)) || \
+       ::LOG::IsBenchmarkTraceEnabled()) ? \
       ::LOG::TypedBenchmark(ELOG_I_STRINGIZE(name), \
                             ::LOG::TypeInfo(::LOG::Type<type>()), \
-                            ELOG_I_FILE, ELOG_I_LINE, verbosity)); else
+                            ELOG_I_FILE, ELOG_I_LINE, verbosity) : \
+      ::LOG::TypedBenchmark()); else
 
-#define ELOG_I_BENCHMARK_4(suite, type, verbosity, name) \
+# define ELOG_I_BENCHMARK_4(suite, type, verbosity, name) \
   if (::LOG::TypedBenchmark name = \
+      ::LOG::IsBenchmarkEnabled() ? \
       ::LOG::TypedBenchmark(ELOG_I_STRINGIZE(name), \
                             ::LOG::TypeInfo(::LOG::Type<type>()), \
-                            ELOG_I_FILE, ELOG_I_LINE, verbosity, &suite)); else
+                            ELOG_I_FILE, ELOG_I_LINE, verbosity, &suite, \
+                            NULL, \
+                            &::LOG::BenchmarkCaseSiteHolder< \
+                                ::LOG::TranslationUnitTag, \
+                                ELOG_I_LINE>::site) : \
+      ::LOG::TypedBenchmark()); else
+
+#endif  // ELOG_DISABLE_BENCHMARK
 
 #endif  // ELOG_BENCHMARK_H_
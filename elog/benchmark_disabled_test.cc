@@ -0,0 +1,65 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#define ELOG_DISABLE_BENCHMARK
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "benchmark.h"
+
+namespace LOG {
+
+namespace {
+
+class SomeModule {};
+
+}  // anonymous namespace
+
+class BenchmarkDisabledTest : public ::testing::Test {
+ public:
+  BenchmarkDisabledTest()
+      : logger_(stream_) {
+  }
+
+ protected:
+  virtual void SetUp() {
+    SetLogger(logger_);
+  }
+
+  virtual void TearDown() {
+    UseDefaultLogger();
+  }
+
+  std::string GetMessage() const {
+    return stream_.str();
+  }
+
+ private:
+  std::ostringstream stream_;
+  StreamLogger logger_;
+};
+
+TEST_F(BenchmarkDisabledTest, BenchmarksRemoved) {
+  BenchmarkSuite suite("suite");
+  int count = 0;
+  BENCHMARK(bench) {
+    ++count;
+    EXPECT_EQ(0, bench.GetTime());
+    bench.Print();
+  }
+  BENCHMARK(suite, bench_in_suite) {
+    ++count;
+  }
+  BENCHMARK(SomeModule, 0, typed_bench) {
+    ++count;
+  }
+  BENCHMARK(suite, SomeModule, 0, typed_bench_in_suite) {
+    ++count;
+  }
+  EXPECT_EQ(4, count);
+  EXPECT_EQ("", GetMessage());
+  EXPECT_TRUE(suite.GetChart().empty());
+}
+
+}  // namespace LOG
@@ -0,0 +1,463 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BENCHMARK_EXPORT_H_
+#define ELOG_BENCHMARK_EXPORT_H_
+
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "benchmark_suite.h"
+#include "latency_histogram.h"
+
+namespace LOG {
+
+// Machine-readable results of a BenchmarkSuite. Times are in seconds per
+// iteration, except the time of all the runs.
+//
+// JSON:
+//   {"title": ..., "total_time": ..., "cases": [
+//     {"name": ..., "runs": ..., "iterations": ..., "time": ...,
+//      "min": ..., "median": ..., "mean": ..., "stddev": ..., "p90": ...,
+//      "p99": ..., "p999": ..., "max": ..., "ops_per_sec": ...,
+//      "histogram": [[lower bound, upper bound, count], ...]}, ...]}
+//
+// CSV: a header row, and a row per case of the same fields except the
+// histogram, prefixed by the suite title.
+//
+// Nested cases are named by the path from the outermost case, such as
+// "outer/inner".
+
+struct BenchmarkExportFormatError : virtual std::exception {};
+
+struct BenchmarkRecord {
+  std::string name;
+  long long runs;
+  long long iterations;
+  double time;
+  BenchmarkStatistics statistics;
+};
+
+struct BenchmarkReport {
+  std::string title;
+  std::vector<BenchmarkRecord> records;
+
+  // Returns NULL if no case has the name.
+  const BenchmarkRecord* Find(const std::string& name) const {
+    for (std::size_t i = 0; i < records.size(); ++i) {
+      if (records[i].name == name) return &records[i];
+    }
+    return NULL;
+  }
+};
+
+const char* const kBenchmarkFieldNames[] = {
+  "runs", "iterations", "time", "min", "median", "mean", "stddev", "p90",
+  "p99", "p999", "max", "ops_per_sec"
+};
+
+const std::size_t kNumBenchmarkFields =
+    sizeof(kBenchmarkFieldNames) / sizeof(kBenchmarkFieldNames[0]);
+
+inline double GetBenchmarkField(const BenchmarkRecord& record,
+                                std::size_t index) {
+  const BenchmarkStatistics& statistics = record.statistics;
+  switch (index) {
+    case 0: return static_cast<double>(record.runs);
+    case 1: return static_cast<double>(record.iterations);
+    case 2: return record.time;
+    case 3: return statistics.min;
+    case 4: return statistics.median;
+    case 5: return statistics.mean;
+    case 6: return statistics.stddev;
+    case 7: return statistics.p90;
+    case 8: return statistics.p99;
+    case 9: return statistics.p999;
+    case 10: return statistics.max;
+    default: return statistics.ops_per_sec;
+  }
+}
+
+inline void SetBenchmarkField(BenchmarkRecord& record,
+                              std::size_t index,
+                              double value) {
+  BenchmarkStatistics& statistics = record.statistics;
+  switch (index) {
+    case 0:
+      record.runs = static_cast<long long>(value);
+      statistics.num_samples = record.runs;
+      break;
+    case 1: record.iterations = static_cast<long long>(value); break;
+    case 2: record.time = value; break;
+    case 3: statistics.min = value; break;
+    case 4: statistics.median = value; break;
+    case 5: statistics.mean = value; break;
+    case 6: statistics.stddev = value; break;
+    case 7: statistics.p90 = value; break;
+    case 8: statistics.p99 = value; break;
+    case 9: statistics.p999 = value; break;
+    case 10: statistics.max = value; break;
+    default: statistics.ops_per_sec = value; break;
+  }
+}
+
+// Returns kNumBenchmarkFields for unknown names.
+inline std::size_t FindBenchmarkField(const std::string& name) {
+  std::size_t index = 0;
+  while (index < kNumBenchmarkFields && name != kBenchmarkFieldNames[index]) {
+    ++index;
+  }
+  return index;
+}
+
+// Names of the enclosing cases and the case joined by '/'.
+inline std::string GetBenchmarkCasePath(const BenchmarkSuite::Chart& chart,
+                                        std::size_t case_id) {
+  std::string path = chart[case_id].name;
+  for (std::size_t id = chart[case_id].parent;
+       id != BenchmarkCase::kNoParent; id = chart[id].parent) {
+    path = chart[id].name + '/' + path;
+  }
+  return path;
+}
+
+inline BenchmarkRecord MakeBenchmarkRecord(const BenchmarkSuite::Chart& chart,
+                                           std::size_t case_id) {
+  const BenchmarkCase& benchmark_case = chart[case_id];
+  const BenchmarkRecord record = {
+    GetBenchmarkCasePath(chart, case_id),
+    benchmark_case.histogram.count(),
+    benchmark_case.num_iterations,
+    benchmark_case.time,
+    ComputeBenchmarkStatistics(benchmark_case.histogram)
+  };
+  return record;
+}
+
+inline void WriteJsonString(const std::string& s, std::ostream& os) {
+  os << '"';
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const unsigned char c = s[i];
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      std::sprintf(escaped, "\\u%04x", c);
+      os << escaped;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+inline void WriteCsvString(const std::string& s, std::ostream& os) {
+  if (s.find_first_of(",\"\r\n") == std::string::npos) {
+    os << s;
+    return;
+  }
+  os << '"';
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '"') os << '"';
+    os << s[i];
+  }
+  os << '"';
+}
+
+// Reader of the JSON written by WriteBenchmarkJson(). Unknown members are
+// skipped.
+class BenchmarkJsonReader {
+ public:
+  explicit BenchmarkJsonReader(std::istream& stream)
+      : stream_(stream) {
+  }
+
+  void Read(BenchmarkReport& report) {
+    Expect('{');
+    if (TryConsume('}')) return;
+    do {
+      const std::string key = ReadString();
+      Expect(':');
+      if (key == "title") {
+        report.title = ReadString();
+      } else if (key == "cases") {
+        Expect('[');
+        if (!TryConsume(']')) {
+          do {
+            report.records.push_back(ReadRecord());
+          } while (TryConsume(','));
+          Expect(']');
+        }
+      } else {
+        SkipValue();
+      }
+    } while (TryConsume(','));
+    Expect('}');
+  }
+
+ private:
+  BenchmarkRecord ReadRecord() {
+    BenchmarkRecord record = BenchmarkRecord();
+    Expect('{');
+    if (TryConsume('}')) return record;
+    do {
+      const std::string key = ReadString();
+      Expect(':');
+      const std::size_t field = FindBenchmarkField(key);
+      if (key == "name") {
+        record.name = ReadString();
+      } else if (field < kNumBenchmarkFields) {
+        SetBenchmarkField(record, field, ReadNumber());
+      } else {
+        SkipValue();
+      }
+    } while (TryConsume(','));
+    Expect('}');
+    return record;
+  }
+
+  int Peek() {
+    stream_ >> std::ws;
+    return stream_.peek();
+  }
+
+  bool TryConsume(char c) {
+    if (Peek() != c) return false;
+    stream_.get();
+    return true;
+  }
+
+  void Expect(char c) {
+    if (!TryConsume(c)) throw BenchmarkExportFormatError();
+  }
+
+  std::string ReadString() {
+    Expect('"');
+    std::string s;
+    for (;;) {
+      const int c = stream_.get();
+      if (c == EOF) throw BenchmarkExportFormatError();
+      if (c == '"') return s;
+      if (c != '\\') {
+        s += static_cast<char>(c);
+        continue;
+      }
+      const int escaped = stream_.get();
+      switch (escaped) {
+        case 'b': s += '\b'; break;
+        case 'f': s += '\f'; break;
+        case 'n': s += '\n'; break;
+        case 'r': s += '\r'; break;
+        case 't': s += '\t'; break;
+        case 'u': {
+          char digits[5] = {};
+          if (!stream_.read(digits, 4)) throw BenchmarkExportFormatError();
+          // Only characters written by WriteJsonString() are supported.
+          s += static_cast<char>(std::strtol(digits, NULL, 16));
+          break;
+        }
+        case EOF:
+          throw BenchmarkExportFormatError();
+        default:
+          s += static_cast<char>(escaped);
+          break;
+      }
+    }
+  }
+
+  double ReadNumber() {
+    Peek();
+    double number;
+    if (!(stream_ >> number)) throw BenchmarkExportFormatError();
+    return number;
+  }
+
+  void SkipValue() {
+    const int c = Peek();
+    if (c == '"') {
+      ReadString();
+    } else if (c == '[' || c == '{') {
+      const char close = c == '[' ? ']' : '}';
+      stream_.get();
+      if (TryConsume(close)) return;
+      do {
+        if (close == '}') {
+          ReadString();
+          Expect(':');
+        }
+        SkipValue();
+      } while (TryConsume(','));
+      Expect(close);
+    } else if (std::isalpha(c)) {
+      while (std::isalpha(stream_.peek())) {
+        stream_.get();
+      }
+    } else {
+      ReadNumber();
+    }
+  }
+
+  std::istream& stream_;
+};
+
+// Splits a line of CSV written by WriteBenchmarkCsv().
+inline std::vector<std::string> SplitCsvLine(const std::string& line) {
+  std::vector<std::string> cells(1);
+  bool is_quoted = false;
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    const char c = line[i];
+    if (is_quoted) {
+      if (c != '"') {
+        cells.back() += c;
+      } else if (i + 1 < line.size() && line[i + 1] == '"') {
+        cells.back() += '"';
+        ++i;
+      } else {
+        is_quoted = false;
+      }
+    } else if (c == '"') {
+      is_quoted = true;
+    } else if (c == ',') {
+      cells.push_back(std::string());
+    } else if (c != '\r') {
+      cells.back() += c;
+    }
+  }
+  return cells;
+}
+
+inline void ReadBenchmarkCsv(std::istream& stream, BenchmarkReport& report) {
+  std::string line;
+  if (!std::getline(stream, line)) throw BenchmarkExportFormatError();
+  const std::vector<std::string> header = SplitCsvLine(line);
+  if (header.size() < 2 || header[0] != "suite" || header[1] != "case") {
+    throw BenchmarkExportFormatError();
+  }
+  while (std::getline(stream, line)) {
+    if (line.empty()) continue;
+    const std::vector<std::string> cells = SplitCsvLine(line);
+    if (cells.size() != header.size()) throw BenchmarkExportFormatError();
+    report.title = cells[0];
+    BenchmarkRecord record = BenchmarkRecord();
+    record.name = cells[1];
+    for (std::size_t i = 2; i < cells.size(); ++i) {
+      const std::size_t field = FindBenchmarkField(header[i]);
+      if (field == kNumBenchmarkFields) continue;
+      char* end;
+      const double value = std::strtod(cells[i].c_str(), &end);
+      if (cells[i].empty() || *end) throw BenchmarkExportFormatError();
+      SetBenchmarkField(record, field, value);
+    }
+    report.records.push_back(record);
+  }
+}
+
+inline void WriteBenchmarkJson(const BenchmarkSuite& suite, std::ostream& os) {
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  const std::streamsize precision = os.precision(17);
+  os << "{\"title\": ";
+  WriteJsonString(suite.title(), os);
+  os << ", \"total_time\": " << suite.GetTotalTime() << ", \"cases\": [";
+  for (std::size_t i = 0; i < chart.size(); ++i) {
+    const BenchmarkRecord record = MakeBenchmarkRecord(chart, i);
+    os << (i ? ",\n  " : "\n  ") << "{\"name\": ";
+    WriteJsonString(record.name, os);
+    for (std::size_t j = 0; j < kNumBenchmarkFields; ++j) {
+      os << ", \"" << kBenchmarkFieldNames[j] << "\": "
+         << GetBenchmarkField(record, j);
+    }
+
+    os << ", \"histogram\": [";
+    const LatencyHistogram& histogram = chart[i].histogram;
+    bool is_first = true;
+    for (std::size_t j = 0; j < LatencyHistogram::kNumBuckets; ++j) {
+      const long long count = histogram.bucket_count(j);
+      if (!count) continue;
+      os << (is_first ? "[" : ", [")
+         << LatencyHistogram::GetBucketLowerBound(j) * 1e-12 << ", "
+         << LatencyHistogram::GetBucketUpperBound(j) * 1e-12 << ", "
+         << count << "]";
+      is_first = false;
+    }
+    os << "]}";
+  }
+  os << "\n]}\n";
+  os.precision(precision);
+}
+
+inline void WriteBenchmarkCsv(const BenchmarkSuite& suite, std::ostream& os) {
+  os << "suite,case";
+  for (std::size_t i = 0; i < kNumBenchmarkFields; ++i) {
+    os << ',' << kBenchmarkFieldNames[i];
+  }
+  os << '\n';
+  const std::streamsize precision = os.precision(17);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  for (std::size_t i = 0; i < chart.size(); ++i) {
+    const BenchmarkRecord record = MakeBenchmarkRecord(chart, i);
+    WriteCsvString(suite.title(), os);
+    os << ',';
+    WriteCsvString(record.name, os);
+    for (std::size_t j = 0; j < kNumBenchmarkFields; ++j) {
+      os << ',' << GetBenchmarkField(record, j);
+    }
+    os << '\n';
+  }
+  os.precision(precision);
+}
+
+// Reads the output of either WriteBenchmarkJson() or WriteBenchmarkCsv().
+// Throws BenchmarkExportFormatError on broken input.
+inline BenchmarkReport ReadBenchmarkReport(std::istream& stream) {
+  BenchmarkReport report;
+  stream >> std::ws;
+  if (stream.peek() == '{') {
+    BenchmarkJsonReader(stream).Read(report);
+  } else {
+    ReadBenchmarkCsv(stream, report);
+  }
+  return report;
+}
+
+struct BenchmarkComparison {
+  std::string name;
+  double baseline_median;
+  double current_median;
+  double change;  // relative change of the median
+  bool is_regressed;
+};
+
+// Compares the medians of the cases found in both reports. A case regresses
+// if its median grows more than the threshold, e.g. 0.05 for 5%.
+inline std::vector<BenchmarkComparison> CompareBenchmarkReports(
+    const BenchmarkReport& baseline,
+    const BenchmarkReport& current,
+    double threshold) {
+  std::vector<BenchmarkComparison> comparisons;
+  for (std::size_t i = 0; i < current.records.size(); ++i) {
+    const BenchmarkRecord& record = current.records[i];
+    const BenchmarkRecord* baseline_record = baseline.Find(record.name);
+    if (!baseline_record) continue;
+
+    const double baseline_median = baseline_record->statistics.median;
+    const double current_median = record.statistics.median;
+    const double change = baseline_median > 0 ?
+        current_median / baseline_median - 1 : 0;
+    const BenchmarkComparison comparison = {
+      record.name, baseline_median, current_median, change,
+      change > threshold
+    };
+    comparisons.push_back(comparison);
+  }
+  return comparisons;
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_BENCHMARK_EXPORT_H_
@@ -0,0 +1,106 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "benchmark_export.h"
+#include "benchmark_suite.h"
+
+namespace LOG {
+
+namespace {
+
+void AddCases(BenchmarkSuite& suite, double scale) {
+  for (int i = 1; i <= 10; ++i) {
+    suite.AddCase("fast", i * 1e-6 * scale, 10);
+    suite.AddCase("slow, \"quoted\"", i * 1e-3 * scale);
+  }
+}
+
+void VerifyReport(const BenchmarkSuite& suite, const BenchmarkReport& report) {
+  EXPECT_EQ(suite.title(), report.title);
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(chart.size(), report.records.size());
+  for (std::size_t i = 0; i < chart.size(); ++i) {
+    const BenchmarkRecord& record = report.records[i];
+    const BenchmarkStatistics statistics =
+        ComputeBenchmarkStatistics(chart[i].histogram);
+    EXPECT_EQ(chart[i].name, record.name);
+    EXPECT_EQ(chart[i].histogram.count(), record.runs);
+    EXPECT_EQ(chart[i].num_iterations, record.iterations);
+    EXPECT_DOUBLE_EQ(chart[i].time, record.time);
+    EXPECT_DOUBLE_EQ(statistics.min, record.statistics.min);
+    EXPECT_DOUBLE_EQ(statistics.median, record.statistics.median);
+    EXPECT_DOUBLE_EQ(statistics.stddev, record.statistics.stddev);
+    EXPECT_DOUBLE_EQ(statistics.p999, record.statistics.p999);
+    EXPECT_DOUBLE_EQ(statistics.ops_per_sec, record.statistics.ops_per_sec);
+  }
+}
+
+TEST(BenchmarkExportTest, Json) {
+  BenchmarkSuite suite("suite \"title\"\n");
+  AddCases(suite, 1);
+  std::stringstream stream;
+  WriteBenchmarkJson(suite, stream);
+  EXPECT_NE(std::string::npos, stream.str().find("\"histogram\": [["));
+  VerifyReport(suite, ReadBenchmarkReport(stream));
+}
+
+TEST(BenchmarkExportTest, Csv) {
+  BenchmarkSuite suite("suite, title");
+  AddCases(suite, 1);
+  std::stringstream stream;
+  WriteBenchmarkCsv(suite, stream);
+  EXPECT_EQ(0u, stream.str().find("suite,case,runs,"));
+  VerifyReport(suite, ReadBenchmarkReport(stream));
+}
+
+TEST(BenchmarkExportTest, NestedCasesAreNamedByPath) {
+  BenchmarkSuite suite("suite");
+  const std::size_t outer = suite.EnterScope(NULL, "outer");
+  suite.ExitScope(suite.EnterScope(NULL, "inner"), 1.0);
+  suite.ExitScope(outer, 2.0);
+  std::stringstream stream;
+  WriteBenchmarkCsv(suite, stream);
+  const BenchmarkReport report = ReadBenchmarkReport(stream);
+  ASSERT_EQ(2u, report.records.size());
+  EXPECT_EQ("outer", report.records[0].name);
+  EXPECT_EQ("outer/inner", report.records[1].name);
+}
+
+TEST(BenchmarkExportTest, BrokenInput) {
+  std::istringstream json("{\"title\": \"suite\", \"cases\": [{\"name\": 1");
+  EXPECT_THROW(ReadBenchmarkReport(json), BenchmarkExportFormatError);
+  std::istringstream csv("suite,case,runs\nsuite,case,x\n");
+  EXPECT_THROW(ReadBenchmarkReport(csv), BenchmarkExportFormatError);
+}
+
+TEST(BenchmarkExportTest, Compare) {
+  BenchmarkSuite baseline_suite("suite"), current_suite("suite");
+  AddCases(baseline_suite, 1);
+  AddCases(current_suite, 1.2);
+  current_suite.AddCase("new", 1);
+  std::stringstream baseline_stream, current_stream;
+  WriteBenchmarkJson(baseline_suite, baseline_stream);
+  WriteBenchmarkCsv(current_suite, current_stream);
+  const BenchmarkReport baseline = ReadBenchmarkReport(baseline_stream);
+  const BenchmarkReport current = ReadBenchmarkReport(current_stream);
+
+  std::vector<BenchmarkComparison> comparisons =
+      CompareBenchmarkReports(baseline, current, 0.1);
+  ASSERT_EQ(2u, comparisons.size());
+  EXPECT_EQ("fast", comparisons[0].name);
+  EXPECT_NEAR(0.2, comparisons[0].change, 0.05);
+  EXPECT_TRUE(comparisons[0].is_regressed);
+  EXPECT_TRUE(comparisons[1].is_regressed);
+
+  comparisons = CompareBenchmarkReports(baseline, current, 0.5);
+  EXPECT_FALSE(comparisons[0].is_regressed);
+  EXPECT_FALSE(comparisons[1].is_regressed);
+}
+
+}  // namespace
+
+}  // namespace LOG
@@ -0,0 +1,106 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BENCHMARK_RUNNER_H_
+#define ELOG_BENCHMARK_RUNNER_H_
+
+#include <cstddef>
+#include <string>
+#include "benchmark_suite.h"
+#include "timer.h"
+#include "util.h"
+
+namespace LOG {
+
+// Runs a case repeatedly and adds each run to a BenchmarkSuite as a sample.
+// The number of iterations per run is doubled until a run takes at least the
+// minimum sample time, so that the resolution of the clock is negligible.
+// Warmup runs are discarded.
+//
+//   LOG::BenchmarkSuite suite("my experiments");
+//   LOG::BenchmarkRunner runner(suite);
+//   runner.Run("first_exp", SomeFunction);
+//   suite.LogChart();
+class BenchmarkRunner : Noncopyable {
+ public:
+  static const int kDefaultNumWarmupRuns = 1;
+  static const int kDefaultNumRuns = 20;
+
+  explicit BenchmarkRunner(BenchmarkSuite& suite)
+      : suite_(suite),
+        num_warmup_runs_(kDefaultNumWarmupRuns),
+        num_runs_(kDefaultNumRuns),
+        min_sample_time_(0.01) {
+  }
+
+  int num_warmup_runs() const {
+    return num_warmup_runs_;
+  }
+
+  void set_num_warmup_runs(int num_warmup_runs) {
+    num_warmup_runs_ = num_warmup_runs;
+  }
+
+  int num_runs() const {
+    return num_runs_;
+  }
+
+  void set_num_runs(int num_runs) {
+    num_runs_ = num_runs;
+  }
+
+  double min_sample_time() const {
+    return min_sample_time_;
+  }
+
+  void set_min_sample_time(double min_sample_time) {
+    min_sample_time_ = min_sample_time;
+  }
+
+  // Calls function() as many times as calibrated in each run. Returns the
+  // number of iterations per run.
+  template <typename Function>
+  long long Run(const std::string& case_name, Function function) {
+    const std::size_t case_id = suite_.GetCaseId(case_name);
+    const long long num_iterations = Calibrate(function);
+    for (int i = 0; i < num_warmup_runs_; ++i) {
+      RunIterations(function, num_iterations);
+    }
+    for (int i = 0; i < num_runs_; ++i) {
+      suite_.AddSample(case_id, RunIterations(function, num_iterations),
+                       num_iterations);
+    }
+    return num_iterations;
+  }
+
+ private:
+  static const long long kMaxNumIterations = 1LL << 40;
+
+  template <typename Function>
+  long long Calibrate(Function& function) const {
+    long long num_iterations = 1;
+    while (num_iterations < kMaxNumIterations &&
+           RunIterations(function, num_iterations) < min_sample_time_) {
+      num_iterations *= 2;
+    }
+    return num_iterations;
+  }
+
+  template <typename Function>
+  static double RunIterations(Function& function, long long num_iterations) {
+    Timer timer;
+    for (long long i = 0; i < num_iterations; ++i) {
+      function();
+    }
+    return timer.GetTime();
+  }
+
+  BenchmarkSuite& suite_;
+  int num_warmup_runs_;
+  int num_runs_;
+  double min_sample_time_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_BENCHMARK_RUNNER_H_
@@ -4,29 +4,211 @@
 #ifndef ELOG_BENCHMARK_SUITE_H_
 #define ELOG_BENCHMARK_SUITE_H_
 
+#include "config.h"
+
 #include <cstddef>
 #include <algorithm>
 #include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
+#include "atomic.h"
+#include "latency_histogram.h"
 #include "logger.h"
 #include "logger_factory.h"
 #include "mutex.h"
+#include "perf_counters.h"
+#include "thread.h"
 #include "timer.h"
+#include "util.h"
 
 namespace LOG {
 
-class BenchmarkSuite {
+// Samples of a case. The memory does not grow with the number of samples, so
+// BENCHMARK blocks can run in loops. It is about 25 KB, most of which is the
+// buckets of the histogram.
+struct BenchmarkAccumulator {
+  BenchmarkAccumulator()
+      : time(0),
+        num_iterations(0) {
+    std::fill(perf_counter_sums, perf_counter_sums + kNumPerfCounters, 0);
+    std::fill(perf_counter_runs, perf_counter_runs + kNumPerfCounters, 0);
+  }
+
+  void Add(double run_time, long long run_iterations) {
+    histogram.Record(
+        static_cast<long long>(run_time * 1e12 / run_iterations + 0.5));
+    time += run_time;
+    num_iterations += run_iterations;
+  }
+
+  void AddPerfCounters(const PerfCounterValues& values) {
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      if (values.values[i] == kPerfCounterUnavailable) continue;
+      perf_counter_sums[i] += values.values[i];
+      ++perf_counter_runs[i];
+    }
+  }
+
+  void Merge(const BenchmarkAccumulator& accumulator) {
+    histogram.Merge(accumulator.histogram);
+    time += accumulator.time;
+    num_iterations += accumulator.num_iterations;
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      perf_counter_sums[i] += accumulator.perf_counter_sums[i];
+      perf_counter_runs[i] += accumulator.perf_counter_runs[i];
+    }
+  }
+
+  LatencyHistogram histogram;  // picoseconds per iteration of each run
+  double time;  // seconds of all the runs
+  long long num_iterations;  // of all the runs
+  long long perf_counter_sums[kNumPerfCounters];  // of the counted runs
+  long long perf_counter_runs[kNumPerfCounters];  // counted by the counter
+};
+
+// Samples of a case recorded by a thread.
+struct BenchmarkThreadShare {
+  // GetThreadIndex() of the thread modulo kMaxNumThreadSlots of
+  // BenchmarkSuite, or kMaxNumThreadSlots for the samples recorded under the
+  // lock.
+  std::size_t thread_index;
+  long long num_samples;
+  double time;
+};
+
+// Samples of a case, grouped by the case name and the enclosing case.
+struct BenchmarkCase : BenchmarkAccumulator {
+  static const std::size_t kNoParent = static_cast<std::size_t>(-1);
+
+  BenchmarkCase()
+      : parent(kNoParent) {
+  }
+
+  std::string name;
+  std::size_t parent;  // id of the enclosing case
+  std::vector<BenchmarkThreadShare> threads;
+};
+
+class BenchmarkSuite;
+
+// Running BENCHMARK scope.
+struct BenchmarkScope {
+  BenchmarkSuite* suite;
+  std::size_t case_id;
+};
+
+// Stack of the running scopes of the current thread. Scopes nested deeper
+// than kMaxDepth are recorded, but do not become parents.
+template <AvoidODR>
+struct BenchmarkScopeStackTemplate {
+  static const std::size_t kMaxDepth = 64;
+
+  static ELOG_I_THREAD_LOCAL BenchmarkScope scopes[kMaxDepth];
+  static ELOG_I_THREAD_LOCAL std::size_t depth;
+};
+
+template <AvoidODR N>
+ELOG_I_THREAD_LOCAL BenchmarkScope BenchmarkScopeStackTemplate<N>::scopes[
+    BenchmarkScopeStackTemplate<N>::kMaxDepth];
+
+template <AvoidODR N>
+ELOG_I_THREAD_LOCAL std::size_t BenchmarkScopeStackTemplate<N>::depth;
+
+typedef BenchmarkScopeStackTemplate<AVOID_ODR> BenchmarkScopeStack;
+
+// Id of the case of a BENCHMARK statement, cached for the last suite and the
+// last enclosing case.
+struct BenchmarkCaseSite {
+  volatile std::size_t key;  // zero if not cached yet
+};
+
+template <typename TranslationUnit, int LINE>
+struct BenchmarkCaseSiteHolder {
+  static BenchmarkCaseSite site;
+};
+
+template <typename TranslationUnit, int LINE>
+BenchmarkCaseSite BenchmarkCaseSiteHolder<TranslationUnit, LINE>::site = {
+  0
+};
+
+template <AvoidODR>
+struct BenchmarkSuiteCountTemplate {
+  static volatile std::size_t value;
+};
+
+template <AvoidODR N>
+volatile std::size_t BenchmarkSuiteCountTemplate<N>::value;
+
+typedef BenchmarkSuiteCountTemplate<AVOID_ODR> BenchmarkSuiteCount;
+
+// Times are in seconds per iteration.
+struct BenchmarkStatistics {
+  long long num_samples;
+  double min;
+  double median;
+  double mean;
+  double stddev;
+  double p90;
+  double p99;
+  double p999;
+  double max;
+  double ops_per_sec;
+};
+
+inline BenchmarkStatistics ComputeBenchmarkStatistics(
+    const LatencyHistogram& histogram) {
+  const BenchmarkStatistics statistics = {
+    histogram.count(),
+    histogram.min() * 1e-12,
+    histogram.GetValueAtQuantile(0.5) * 1e-12,
+    histogram.mean() * 1e-12,
+    histogram.stddev() * 1e-12,
+    histogram.GetValueAtQuantile(0.9) * 1e-12,
+    histogram.GetValueAtQuantile(0.99) * 1e-12,
+    histogram.GetValueAtQuantile(0.999) * 1e-12,
+    histogram.max() * 1e-12,
+    histogram.mean() > 0 ? 1e12 / histogram.mean() : 0
+  };
+  return statistics;
+}
+
+// Collection of benchmark results. Each thread records samples in the slot of
+// its GetThreadIndex() modulo kMaxNumThreadSlots, which it claims by a
+// compare-and-swap that only contends with the threads sharing the slot and
+// with GetChart(); the slots are merged when the chart is made. Samples of the
+// cases after the first kMaxNumCaseSlots of the suite are recorded under a
+// lock.
+//
+// A slot has a BenchmarkAccumulator of about 25 KB for each case recorded in
+// it, so the memory is bounded by kMaxNumThreadSlots * kMaxNumCaseSlots of
+// them, and is usually about 25 KB * cases * threads.
+class BenchmarkSuite : Noncopyable {
  public:
-  typedef std::vector<std::pair<std::string, double> > Chart;
+  typedef std::vector<BenchmarkCase> Chart;
 
   static const int kDefaultPrecision = 5;
+  static const std::size_t kMaxNumThreadSlots = 256;
+  static const std::size_t kMaxNumCaseSlots = 256;
 
   explicit BenchmarkSuite(const std::string& title)
-      : title_(title),
+      : serial_(FetchAndAdd(BenchmarkSuiteCount::value, 1) + 1),
+        title_(title),
         precision_(kDefaultPrecision) {
+    std::fill(thread_slots_, thread_slots_ + kMaxNumThreadSlots,
+              static_cast<ThreadSlot*>(NULL));
+    for (std::size_t i = 0; i < kMaxNumCaseSlots; ++i) {
+      case_parents_[i] = BenchmarkCase::kNoParent;
+    }
+  }
+
+  ~BenchmarkSuite() {
+    for (std::size_t i = 0; i < kMaxNumThreadSlots; ++i) {
+      delete thread_slots_[i];
+    }
   }
 
   const std::string& title() const {
@@ -37,9 +219,154 @@ class BenchmarkSuite {
     precision_ = precision;
   }
 
-  void AddCase(const std::string& case_name, double time) {
+  // Interns the case name under the parent case. Ids are assigned from zero
+  // in order of the first appearance.
+  std::size_t GetCaseId(std::size_t parent, const std::string& case_name) {
+    MutexLock lock(chart_mutex_);
+    const std::pair<CaseIndices::iterator, bool> inserted =
+        case_indices_.insert(std::make_pair(std::make_pair(parent, case_name),
+                                            chart_.size()));
+    if (inserted.second) {
+      chart_.push_back(BenchmarkCase());
+      chart_.back().name = case_name;
+      chart_.back().parent = parent;
+      if (chart_.size() <= kMaxNumCaseSlots) {
+        case_parents_[chart_.size() - 1] = parent;
+      }
+    }
+    return inserted.first->second;
+  }
+
+  std::size_t GetCaseId(const std::string& case_name) {
+    return GetCaseId(BenchmarkCase::kNoParent, case_name);
+  }
+
+  // Same as above, but the id is cached in the site.
+  std::size_t GetCaseId(BenchmarkCaseSite& site,
+                        std::size_t parent,
+                        const std::string& case_name) {
+    const std::size_t key = site.key;
+    if (key / kMaxNumCaseSlots == serial_ &&
+        case_parents_[key % kMaxNumCaseSlots] == parent) {
+      return key % kMaxNumCaseSlots;
+    }
+    const std::size_t case_id = GetCaseId(parent, case_name);
+    if (case_id < kMaxNumCaseSlots) {
+      site.key = serial_ * kMaxNumCaseSlots + case_id;
+    }
+    return case_id;
+  }
+
+  std::size_t GetCaseId(BenchmarkCaseSite& site,
+                        const std::string& case_name) {
+    return GetCaseId(site, BenchmarkCase::kNoParent, case_name);
+  }
+
+  // Starts a scope of the case in the current thread. The case is a child of
+  // the innermost running scope of this suite in the thread. The site may be
+  // NULL.
+  std::size_t EnterScope(BenchmarkCaseSite* site,
+                         const std::string& case_name) {
+    std::size_t parent = BenchmarkCase::kNoParent;
+    for (std::size_t i = BenchmarkScopeStack::depth; i > 0; --i) {
+      if (BenchmarkScopeStack::scopes[i - 1].suite == this) {
+        parent = BenchmarkScopeStack::scopes[i - 1].case_id;
+        break;
+      }
+    }
+    const std::size_t case_id = site ?
+        GetCaseId(*site, parent, case_name) : GetCaseId(parent, case_name);
+
+    const std::size_t depth = BenchmarkScopeStack::depth;
+    if (depth < BenchmarkScopeStack::kMaxDepth) {
+      const BenchmarkScope scope = { this, case_id };
+      BenchmarkScopeStack::scopes[depth] = scope;
+    }
+    BenchmarkScopeStack::depth = depth + 1;
+    return case_id;
+  }
+
+  // Ends the scope started by EnterScope(), and adds the time and the counts
+  // of the events, if any, as a sample. Scopes started after it and not ended
+  // yet are discarded from the stack.
+  void ExitScope(std::size_t case_id,
+                 double time,
+                 const PerfCounterValues* perf_counter_values = NULL) {
+    const std::size_t depth = BenchmarkScopeStack::depth;
+    if (depth > BenchmarkScopeStack::kMaxDepth) {
+      BenchmarkScopeStack::depth = depth - 1;  // the scope was not pushed
+    } else {
+      for (std::size_t i = depth; i > 0; --i) {
+        const BenchmarkScope& scope = BenchmarkScopeStack::scopes[i - 1];
+        if (scope.suite == this && scope.case_id == case_id) {
+          BenchmarkScopeStack::depth = i - 1;
+          break;
+        }
+      }
+    }
+    AddSample(case_id, time, 1, perf_counter_values);
+  }
+
+  // Adds a sample of running the case num_iterations times in the time.
+  void AddCase(const std::string& case_name,
+               double time,
+               long long num_iterations = 1) {
+    AddSample(GetCaseId(case_name), time, num_iterations);
+  }
+
+  void AddCase(BenchmarkCaseSite& site,
+               const std::string& case_name,
+               double time,
+               long long num_iterations = 1) {
+    AddSample(GetCaseId(site, case_name), time, num_iterations);
+  }
+
+  void AddSample(std::size_t case_id,
+                 double time,
+                 long long num_iterations,
+                 const PerfCounterValues* perf_counter_values = NULL) {
+    if (case_id < kMaxNumCaseSlots) {
+      ThreadSlot& thread_slot =
+          GetThreadSlot(GetThreadIndex() % kMaxNumThreadSlots);
+      ThreadSlotClaim claim(thread_slot);
+      Accumulate(thread_slot.GetAccumulator(case_id),
+                 time, num_iterations, perf_counter_values);
+      return;
+    }
     MutexLock lock(chart_mutex_);
-            chart_.push_back(std::make_pair(case_name, time));
+    Accumulate(chart_[case_id], time, num_iterations, perf_counter_values);
+  }
+
+  // Merges the slots, each while it is claimed, so that every sample is
+  // merged either whole or not at all. Samples being recorded by other threads
+  // may be missed.
+  Chart GetChart() const {
+    MutexLock lock(chart_mutex_);
+    Chart chart = chart_;
+    const std::size_t num_case_slots =
+        chart.size() < kMaxNumCaseSlots ? chart.size() : kMaxNumCaseSlots;
+    for (std::size_t j = 0; j < kMaxNumThreadSlots; ++j) {
+      ThreadSlot* thread_slot = thread_slots_[j];
+      if (!thread_slot) continue;
+      ThreadSlotClaim claim(*thread_slot);
+      for (std::size_t i = 0; i < num_case_slots; ++i) {
+        const BenchmarkAccumulator* accumulator = thread_slot->cases[i];
+        if (!accumulator) continue;
+        AddThreadShare(j, *accumulator, chart[i]);
+        chart[i].Merge(*accumulator);
+      }
+    }
+    for (std::size_t i = 0; i < chart.size(); ++i) {
+      if (chart_[i].histogram.count()) {
+        AddThreadShare(kMaxNumThreadSlots, chart_[i], chart[i]);
+      }
+    }
+    return chart;
+  }
+
+  // Seconds since the construction.
+  double GetTotalTime() const {
+    return timer_.GetTime();
   }
 
   void LogChart(LogLevel level = INFO, Logger* logger = NULL) const {
@@ -50,113 +377,336 @@ class BenchmarkSuite {
     logger->PushRawMessage(level, chart_string);
   }
 
+  // Prints the statistics of the time per iteration of each case. Nested
+  // cases are indented below the enclosing ones; the self time excludes the
+  // time of the nested cases. The unit of the time is chosen by the fastest
+  // case. Percentiles are approximated within 1/64 of the values. The counts
+  // of the perf events are the means per run, for the counters used.
   std::string PrintChart() const {
-    static const char kTimeColumnTitle[] = "time (sec)";
-    MutexLock lock(chart_mutex_);
+    const Chart chart = GetChart();
+    const double total = timer_.GetTime();
 
-    const std::size_t title_width = GetMaxTitleLength();
-    const std::size_t time_column_width =
-        std::max(GetTimeColumnWidth(), sizeof(kTimeColumnTitle) - 1);
+    const char* unit_name;
+    const double unit = ChooseUnit(chart, unit_name);
 
-    std::ostringstream stream;
+    std::vector<double> child_times(chart.size());
+    double root_time_sum = 0;
+    for (std::size_t i = 0; i < chart.size(); ++i) {
+      if (chart[i].parent == BenchmarkCase::kNoParent) {
+        root_time_sum += chart[i].time;
+      } else {
+        child_times[chart[i].parent] += chart[i].time;
+      }
+    }
+
+    Table table;
+    table.push_back(Row());
+    Row& top_row = table.back();
+    top_row.push_back(title_);
+    top_row.push_back("runs");
+    top_row.push_back("total (sec)");
+    top_row.push_back("self (sec)");
+    top_row.push_back("% of total");
+    const char* const kStatisticNames[] = {
+      "min", "p50", "mean", "stddev", "p90", "p99", "p999", "max"
+    };
+    for (std::size_t i = 0; i < sizeof(kStatisticNames) / sizeof(char*); ++i) {
+      top_row.push_back(std::string(kStatisticNames[i]) + " (" + unit_name +
+                        ")");
+    }
+    top_row.push_back("ops/sec");
+    std::vector<std::size_t> perf_counters;
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      for (std::size_t j = 0; j < chart.size(); ++j) {
+        if (chart[j].perf_counter_runs[i]) {
+          perf_counters.push_back(i);
+          top_row.push_back(GetPerfCounterName(i));
+          break;
+        }
+      }
+    }
+
+    std::vector<std::size_t> order, depths;
+    GetTreeOrder(chart, order, depths);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      const std::size_t id = order[i];
+      const BenchmarkCase& benchmark_case = chart[id];
+      const BenchmarkStatistics statistics =
+          ComputeBenchmarkStatistics(benchmark_case.histogram);
+
+      table.push_back(Row());
+      Row& row = table.back();
+      row.push_back(std::string(depths[i] * 2, ' ') + benchmark_case.name);
+      row.push_back(FormatCount(statistics.num_samples));
+      row.push_back(FormatTime(benchmark_case.time));
+      row.push_back(FormatTime(
+          std::max(benchmark_case.time - child_times[id], 0.0)));
+      row.push_back(FormatPercentage(benchmark_case.time, total));
+      row.push_back(FormatTime(statistics.min / unit));
+      row.push_back(FormatTime(statistics.median / unit));
+      row.push_back(FormatTime(statistics.mean / unit));
+      row.push_back(FormatTime(statistics.stddev / unit));
+      row.push_back(FormatTime(statistics.p90 / unit));
+      row.push_back(FormatTime(statistics.p99 / unit));
+      row.push_back(FormatTime(statistics.p999 / unit));
+      row.push_back(FormatTime(statistics.max / unit));
+      row.push_back(FormatCount(statistics.ops_per_sec));
+      for (std::size_t j = 0; j < perf_counters.size(); ++j) {
+        const std::size_t counter = perf_counters[j];
+        const long long runs = benchmark_case.perf_counter_runs[counter];
+        row.push_back(runs ? FormatCount(static_cast<double>(
+            benchmark_case.perf_counter_sums[counter]) / runs) : "-");
+      }
+    }
 
-    PrintTopRow(title_width, kTimeColumnTitle, stream);
-    PrintHorizontalSeparator(title_width, time_column_width, stream);
-    PrintAllCasesResult(title_width, time_column_width, stream);
-    PrintHorizontalSeparator(title_width, time_column_width, stream);
-    PrintStatistics(title_width, time_column_width, stream);
+    table.push_back(Row(5));
+    table.back()[0] = "(other)";
+    table.back()[2] = FormatTime(total - root_time_sum);
+    table.back()[4] = FormatPercentage(total - root_time_sum, total);
+    table.push_back(Row(3));
+    table.back()[0] = "total";
+    table.back()[2] = FormatTime(total);
 
+    std::ostringstream stream;
+    PrintTable(table, chart.size(), stream);
+    PrintThreadBreakdown(chart, stream);
     stream << std::flush;
 
     return stream.str();
   }
 
+  // Ids of the cases in depth-first order, where the nested cases follow the
+  // enclosing one, and the depth of each.
+  static void GetTreeOrder(const Chart& chart,
+                           std::vector<std::size_t>& order,
+                           std::vector<std::size_t>& depths) {
+    std::vector<std::vector<std::size_t> > children(chart.size());
+    std::vector<std::size_t> stack;
+    for (std::size_t i = chart.size(); i > 0; --i) {
+      const std::size_t parent = chart[i - 1].parent;
+      if (parent == BenchmarkCase::kNoParent) {
+        stack.push_back(i - 1);
+      } else {
+        children[parent].push_back(i - 1);  // in reverse order
+      }
+    }
+
+    std::vector<std::size_t> depth_of(chart.size());
+    while (!stack.empty()) {
+      const std::size_t id = stack.back();
+      stack.pop_back();
+      order.push_back(id);
+      depths.push_back(depth_of[id]);
+      for (std::size_t i = 0; i < children[id].size(); ++i) {
+        depth_of[children[id][i]] = depth_of[id] + 1;
+        stack.push_back(children[id][i]);
+      }
+    }
+  }
+
  private:
-  static std::size_t GetDecimalPointIndex(double x) {
-    std::size_t position = 1;
-    while (x >= 10) {
-      x /= 10;
-      ++position;
+  typedef std::vector<std::string> Row;
+  typedef std::vector<Row> Table;
+
+  // Accumulators of the threads sharing a slot, which are read and written
+  // only while the slot is claimed.
+  struct ThreadSlot : Noncopyable {
+    ThreadSlot()
+        : is_claimed(0) {
+      std::fill(cases, cases + kMaxNumCaseSlots,
+                static_cast<BenchmarkAccumulator*>(NULL));
     }
-    return position;
+
+    ~ThreadSlot() {
+      for (std::size_t i = 0; i < kMaxNumCaseSlots; ++i) {
+        delete cases[i];
+      }
+    }
+
+    BenchmarkAccumulator& GetAccumulator(std::size_t case_id) {
+      if (!cases[case_id]) {
+        cases[case_id] = new BenchmarkAccumulator;
+      }
+      return *cases[case_id];
+    }
+
+    volatile int is_claimed;
+    BenchmarkAccumulator* cases[kMaxNumCaseSlots];
+  };
+
+  class ThreadSlotClaim : Noncopyable {
+   public:
+    explicit ThreadSlotClaim(ThreadSlot& thread_slot)
+        : thread_slot_(thread_slot) {
+      while (CompareAndSwap(thread_slot_.is_claimed, 0, 1) != 0) {
+        YieldThread();
+      }
+    }
+
+    ~ThreadSlotClaim() {
+      AtomicSet(thread_slot_.is_claimed, 0);
+    }
+
+   private:
+    ThreadSlot& thread_slot_;
+  };
+
+  ThreadSlot& GetThreadSlot(std::size_t slot_index) {
+    ThreadSlot* thread_slot = thread_slots_[slot_index];
+    if (!thread_slot) {
+      ThreadSlot* new_thread_slot = new ThreadSlot;
+      thread_slot = static_cast<ThreadSlot*>(CompareAndSwap(
+          thread_slots_[slot_index], static_cast<ThreadSlot*>(NULL),
+          new_thread_slot));
+      if (thread_slot) {
+        delete new_thread_slot;  // made by another thread sharing the slot
+      } else {
+        thread_slot = new_thread_slot;
+      }
+    }
+    return *thread_slot;
   }
 
-  void PrintTopRow(std::size_t title_width,
-                   const char* time_column_title,
-                   std::ostream& os) const {
-    os << std::left << std::setw(title_width) << title_ << " | "
-       << time_column_title << '\n';
+  static void Accumulate(BenchmarkAccumulator& accumulator,
+                         double time,
+                         long long num_iterations,
+                         const PerfCounterValues* perf_counter_values) {
+    accumulator.Add(time, num_iterations);
+    if (perf_counter_values) {
+      accumulator.AddPerfCounters(*perf_counter_values);
+    }
   }
 
-  void PrintHorizontalSeparator(std::size_t title_width,
-                                std::size_t time_column_width,
-                                std::ostream& os) const {
-    os << std::setw(title_width) << std::setfill('-') << "" << "-+-"
-       << std::setw(time_column_width) << std::setfill('-') << "" << '\n';
+  static void AddThreadShare(std::size_t thread_index,
+                             const BenchmarkAccumulator& accumulator,
+                             BenchmarkCase& benchmark_case) {
+    const BenchmarkThreadShare share = {
+      thread_index, accumulator.histogram.count(), accumulator.time
+    };
+    benchmark_case.threads.push_back(share);
   }
 
-  void PrintAllCasesResult(std::size_t title_width,
-                           std::size_t time_column_width,
-                           std::ostream& os) const {
-    for (std::size_t i = 0; i < chart_.size(); ++i) {
-      PrintCaseResult(chart_[i].first, title_width,
-                      chart_[i].second, time_column_width, os);
+  // Prints the samples and the time of each thread for the cases recorded by
+  // more than one thread, in order to show load imbalance.
+  void PrintThreadBreakdown(const Chart& chart, std::ostream& os) const {
+    Table table;
+    table.push_back(Row());
+    Row& top_row = table.back();
+    top_row.push_back(title_ + " by thread");
+    top_row.push_back("thread");
+    top_row.push_back("runs");
+    top_row.push_back("total (sec)");
+    top_row.push_back("share");
+
+    for (std::size_t i = 0; i < chart.size(); ++i) {
+      const BenchmarkCase& benchmark_case = chart[i];
+      if (benchmark_case.threads.size() < 2) continue;
+      for (std::size_t j = 0; j < benchmark_case.threads.size(); ++j) {
+        const BenchmarkThreadShare& share = benchmark_case.threads[j];
+        table.push_back(Row());
+        Row& row = table.back();
+        row.push_back(j ? "" : benchmark_case.name);
+        row.push_back(share.thread_index < kMaxNumThreadSlots ?
+                      FormatCount(static_cast<double>(share.thread_index)) :
+                      "other");
+        row.push_back(FormatCount(static_cast<double>(share.num_samples)));
+        row.push_back(FormatTime(share.time));
+        row.push_back(FormatPercentage(share.time, benchmark_case.time));
+      }
     }
-  }
+    if (table.size() == 1) return;
 
-  void PrintCaseResult(const std::string& case_title,
-                       std::size_t title_width,
-                       double time,
-                       std::size_t time_column_width,
-                       std::ostream& os) const {
-    SetResultFormat(os);
-    os << std::left << std::setw(title_width) << case_title << " | "
-       << std::right << std::setw(time_column_width) << time << '\n';
+    os << '\n';
+    PrintTable(table, table.size(), os);
   }
 
-  void PrintStatistics(std::size_t title_width,
-                       std::size_t time_column_width,
-                       std::ostream& os) const {
-    const double time_sum = GetTimeSum();
-    const double total = timer_.GetTime();
-    const double other = total - time_sum;
+  double ChooseUnit(const Chart& chart, const char*& unit_name) const {
+    double min = 1;
+    for (std::size_t i = 0; i < chart.size(); ++i) {
+      const LatencyHistogram& histogram = chart[i].histogram;
+      if (histogram.min() > 0) min = std::min(min, histogram.min() * 1e-12);
+    }
+    if (min < 1e-6) {
+      unit_name = "ns";
+      return 1e-9;
+    }
+    if (min < 1e-3) {
+      unit_name = "us";
+      return 1e-6;
+    }
+    if (min < 1) {
+      unit_name = "ms";
+      return 1e-3;
+    }
+    unit_name = "sec";
+    return 1;
+  }
 
-    PrintCaseResult("(other)", title_width, other, time_column_width, os);
-    PrintCaseResult("total", title_width, total, time_column_width, os);
+  std::string FormatTime(double time) const {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(precision_) << time;
+    return stream.str();
   }
 
-  void SetResultFormat(std::ostream& os) const {
-    os << std::setfill(' ') << std::fixed << std::setprecision(precision_);
+  static std::string FormatPercentage(double part, double whole) {
+    return FormatCount(whole > 0 ? part / whole * 100 : 0) + "%";
   }
 
-  std::size_t GetTimeColumnWidth() const {
-    std::size_t decimal_point_index = 1;
-    for (std::size_t i = 0; i < chart_.size(); ++i) {
-      decimal_point_index = std::max(decimal_point_index,
-                                     GetDecimalPointIndex(chart_[i].second));
-    }
-    return decimal_point_index + precision_ + 1;
+  static std::string FormatCount(double count) {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(0) << count;
+    return stream.str();
   }
 
-  std::size_t GetMaxTitleLength() const {
+  // The first column is aligned to the left, and the others to the right.
+  // Rows below the cases are separated by a line.
+  static void PrintTable(const Table& table,
+                         std::size_t num_cases,
+                         std::ostream& os) {
     static const std::size_t kLeftColumnMinSize = 7;
-    std::size_t length = std::max(kLeftColumnMinSize, title_.size());
-    for (std::size_t i = 0; i < chart_.size(); ++i) {
-      length = std::max(length, chart_[i].first.size());
+
+    std::vector<std::size_t> widths(table[0].size());
+    widths[0] = kLeftColumnMinSize;
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      for (std::size_t j = 0; j < table[i].size(); ++j) {
+        widths[j] = std::max(widths[j], table[i][j].size());
+      }
+    }
+
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      if (i == 1 || i == num_cases + 1) {
+        PrintHorizontalSeparator(widths, os);
+      }
+      const Row& row = table[i];
+      os << std::setfill(' ') << std::left << std::setw(widths[0]) << row[0];
+      for (std::size_t j = 1; j < row.size(); ++j) {
+        os << " | " << std::right << std::setw(widths[j]) << row[j];
+      }
+      os << '\n';
     }
-    return length;
   }
 
-  double GetTimeSum() const {
-    double sum = 0.0;
-    for (std::size_t i = 0; i < chart_.size(); ++i) {
-      sum += chart_[i].second;
+  static void PrintHorizontalSeparator(const std::vector<std::size_t>& widths,
+                                       std::ostream& os) {
+    os << std::setfill('-');
+    for (std::size_t i = 0; i < widths.size(); ++i) {
+      if (i) os << "-+-";
+      os << std::setw(widths[i]) << "";
     }
-    return sum;
+    os << '\n';
   }
 
+  typedef std::map<std::pair<std::size_t, std::string>, std::size_t>
+      CaseIndices;
+
+  const std::size_t serial_;  // distinguishes suites in BenchmarkCaseSite
+  ThreadSlot* volatile thread_slots_[kMaxNumThreadSlots];
+  volatile std::size_t case_parents_[kMaxNumCaseSlots];
+
+  // Interned case names and the samples recorded under the lock.
   mutable Mutex chart_mutex_;
   Chart chart_;
+  CaseIndices case_indices_;
   Timer timer_;
   std::string title_;
   int precision_;
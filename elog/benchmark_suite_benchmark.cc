@@ -0,0 +1,85 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the cost of BenchmarkSuite::AddCase() from concurrent threads: the
+// former mutex-protected chart against per-thread slots.
+
+#include "config.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include "benchmark_suite.h"
+#include "mutex.h"
+#include "thread.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+const int kMaxNumThreads = 8;
+
+// The implementation of BenchmarkSuite::AddCase before the per-thread slots.
+class LockedSuite {
+ public:
+  explicit LockedSuite(const std::string&) {}
+
+  void AddCase(const std::string& case_name, double time) {
+    LOG::MutexLock lock(mutex_);
+    cases_[case_name].Add(time, 1);
+  }
+
+ private:
+  LOG::Mutex mutex_;
+  std::map<std::string, LOG::BenchmarkAccumulator> cases_;
+};
+
+void AddCasesToLockedSuite(LockedSuite* suite) {
+  const std::string case_name = "case";
+  for (int i = 0; i < kNumIterations; ++i) {
+    suite->AddCase(case_name, 1e-6);
+  }
+}
+
+void AddCasesToSuite(LOG::BenchmarkSuite* suite) {
+  static LOG::BenchmarkCaseSite site = { 0 };
+  const std::string case_name = "case";
+  for (int i = 0; i < kNumIterations; ++i) {
+    suite->AddCase(site, case_name, 1e-6);
+  }
+}
+
+// Returns nanoseconds per call seen by each thread.
+template <typename Suite>
+double Run(void (*body)(Suite*), int num_threads) {
+  Suite suite("suite");
+  std::vector<LOG::Thread*> threads;
+  LOG::Timer timer;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(new LOG::Thread(std::tr1::bind(body, &suite)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  return timer.GetTime() * 1e9 / kNumIterations;
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::cout << "threads | mutex+map (ns) | per-thread slots (ns)" << std::endl;
+  for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+    std::cout << num_threads
+              << " | " << Run(AddCasesToLockedSuite, num_threads)
+              << " | " << Run(AddCasesToSuite, num_threads) << std::endl;
+  }
+  return 0;
+}
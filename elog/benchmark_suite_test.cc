@@ -0,0 +1,319 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include "config.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include <gtest/gtest.h>
+#include "benchmark.h"
+#include "benchmark_runner.h"
+#include "benchmark_suite.h"
+#include "thread.h"
+
+namespace LOG {
+
+namespace {
+
+TEST(BenchmarkSuiteTest, ComputeStatistics) {
+  LatencyHistogram histogram;
+  for (int i = 1000; i >= 1; --i) {
+    histogram.Record(i * 1000000000LL);  // i milliseconds
+  }
+  const BenchmarkStatistics statistics = ComputeBenchmarkStatistics(histogram);
+  EXPECT_EQ(1000, statistics.num_samples);
+  EXPECT_DOUBLE_EQ(1e-3, statistics.min);
+  EXPECT_NEAR(0.5, statistics.median, 0.5 / 64);
+  EXPECT_DOUBLE_EQ(0.5005, statistics.mean);
+  EXPECT_NEAR(0.288819, statistics.stddev, 1e-6);
+  EXPECT_NEAR(0.9, statistics.p90, 0.9 / 64);
+  EXPECT_NEAR(0.99, statistics.p99, 0.99 / 64);
+  EXPECT_NEAR(0.999, statistics.p999, 0.999 / 64);
+  EXPECT_DOUBLE_EQ(1, statistics.max);
+  EXPECT_DOUBLE_EQ(1 / 0.5005, statistics.ops_per_sec);
+}
+
+TEST(BenchmarkSuiteTest, SamplesAreGroupedByCaseName) {
+  BenchmarkSuite suite("suite");
+  suite.AddCase("a", 1.0);
+  suite.AddCase("b", 2.0);
+  suite.AddCase("a", 3.0, 2);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(2u, chart.size());
+  EXPECT_EQ("a", chart[0].name);
+  EXPECT_EQ(2, chart[0].histogram.count());
+  EXPECT_EQ(1000000000000LL, chart[0].histogram.min());
+  EXPECT_EQ(1500000000000LL, chart[0].histogram.max());
+  EXPECT_DOUBLE_EQ(4.0, chart[0].time);
+  EXPECT_EQ(3, chart[0].num_iterations);
+  EXPECT_EQ("b", chart[1].name);
+}
+
+TEST(BenchmarkSuiteTest, MemoryDoesNotGrowWithSamples) {
+  BenchmarkSuite suite("suite");
+  for (int i = 0; i < 100000; ++i) {
+    suite.AddCase("loop", i * 1e-6);
+  }
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(1u, chart.size());
+  EXPECT_EQ(100000, chart[0].histogram.count());
+  EXPECT_NEAR(0.099999, chart[0].histogram.max() * 1e-12, 1e-9);
+}
+
+TEST(BenchmarkSuiteTest, PrintChart) {
+  BenchmarkSuite suite("suite");
+  suite.AddCase("some_case", 0.5);
+  const std::string chart = suite.PrintChart();
+  EXPECT_NE(std::string::npos, chart.find("p50 (ms)"));
+  EXPECT_NE(std::string::npos, chart.find("p999 (ms)"));
+  EXPECT_NE(std::string::npos, chart.find("ops/sec"));
+  EXPECT_NE(std::string::npos, chart.find("some_case"));
+  EXPECT_NE(std::string::npos, chart.find("500.00000"));
+  EXPECT_NE(std::string::npos, chart.find("(other)"));
+}
+
+TEST(BenchmarkSuiteTest, CaseIdsAreCachedInSites) {
+  BenchmarkSuite suite1("suite1"), suite2("suite2");
+  BenchmarkCaseSite site = { 0 };
+  EXPECT_EQ(0u, suite1.GetCaseId(site, "a"));
+  EXPECT_NE(0u, site.key);
+  EXPECT_EQ(0u, suite1.GetCaseId(site, "a"));
+  suite2.GetCaseId("b");
+  EXPECT_EQ(1u, suite2.GetCaseId(site, "a"));
+  EXPECT_EQ(0u, suite1.GetCaseId(site, "a"));
+  EXPECT_EQ(1u, suite1.GetCaseId("c"));
+}
+
+TEST(BenchmarkSuiteTest, CasesBeyondSlotsAreRecorded) {
+  BenchmarkSuite suite("suite");
+  const std::size_t num_cases = BenchmarkSuite::kMaxNumCaseSlots + 2;
+  for (std::size_t i = 0; i < num_cases; ++i) {
+    std::ostringstream name;
+    name << "case" << i;
+    suite.AddCase(name.str(), 1.0);
+    suite.AddCase(name.str(), 2.0);
+  }
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(num_cases, chart.size());
+  for (std::size_t i = 0; i < num_cases; ++i) {
+    EXPECT_EQ(2, chart[i].histogram.count());
+    EXPECT_DOUBLE_EQ(3.0, chart[i].time);
+    ASSERT_EQ(1u, chart[i].threads.size());
+    EXPECT_EQ(i < BenchmarkSuite::kMaxNumCaseSlots ?
+              GetThreadIndex() : BenchmarkSuite::kMaxNumThreadSlots,
+              chart[i].threads[0].thread_index);
+  }
+}
+
+void RunBenchmarks(BenchmarkSuite* suite, int count) {
+  for (int i = 0; i < count; ++i) {
+    BENCHMARK(*suite, in_thread) {
+    }
+  }
+}
+
+TEST(BenchmarkSuiteTest, ThreadBreakdown) {
+  static const int kNumThreads = 4;
+
+  SetDefaultLoggerLevel(WARN);
+  BenchmarkSuite suite("suite");
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(RunBenchmarks, &suite, (i + 1) * 100)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  SetDefaultLoggerLevel(INFO);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(1u, chart.size());
+  EXPECT_EQ("in_thread", chart[0].name);
+  EXPECT_EQ(1000, chart[0].histogram.count());
+  ASSERT_EQ(static_cast<std::size_t>(kNumThreads), chart[0].threads.size());
+  long long num_samples = 0;
+  for (int i = 0; i < kNumThreads; ++i) {
+    num_samples += chart[0].threads[i].num_samples;
+  }
+  EXPECT_EQ(1000, num_samples);
+  EXPECT_NE(std::string::npos, suite.PrintChart().find("suite by thread"));
+}
+
+void AddSamplesUntilStopped(BenchmarkSuite* suite,
+                            volatile bool* is_stopped) {
+  while (!*is_stopped) {
+    suite->AddCase("case", 1.0);
+  }
+}
+
+void AddSample(BenchmarkSuite* suite) {
+  suite->AddCase("case", 1.0);
+}
+
+TEST(BenchmarkSuiteTest, ChartIsConsistentWhileRecording) {
+  static const int kNumThreads = 2;
+
+  BenchmarkSuite suite("suite");
+  volatile bool is_stopped = false;
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(AddSamplesUntilStopped, &suite, &is_stopped)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < 100; ++i) {
+    const BenchmarkSuite::Chart chart = suite.GetChart();
+    if (chart.empty()) continue;
+    // Each sample adds one to the count and one second to the time.
+    EXPECT_DOUBLE_EQ(static_cast<double>(chart[0].histogram.count()),
+                     chart[0].time);
+    long long num_samples = 0;
+    for (std::size_t j = 0; j < chart[0].threads.size(); ++j) {
+      num_samples += chart[0].threads[j].num_samples;
+    }
+    EXPECT_EQ(chart[0].histogram.count(), num_samples);
+  }
+  is_stopped = true;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+}
+
+TEST(BenchmarkSuiteTest, ThreadSlotsAreShared) {
+  const std::size_t num_slots = BenchmarkSuite::kMaxNumThreadSlots;
+  const std::size_t num_threads = num_slots + 10;
+
+  BenchmarkSuite suite("suite");
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    Thread thread(std::tr1::bind(AddSample, &suite));
+    thread.Run();
+    thread.Join();
+  }
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(1u, chart.size());
+  EXPECT_EQ(static_cast<long long>(num_threads), chart[0].histogram.count());
+  EXPECT_GE(num_slots, chart[0].threads.size());
+  for (std::size_t i = 0; i < chart[0].threads.size(); ++i) {
+    EXPECT_GT(num_slots, chart[0].threads[i].thread_index);
+  }
+}
+
+const std::size_t kNoParent = BenchmarkCase::kNoParent;
+
+TEST(BenchmarkSuiteTest, NestedScopes) {
+  BenchmarkSuite suite("suite");
+  for (int i = 0; i < 3; ++i) {
+    const std::size_t outer = suite.EnterScope(NULL, "outer");
+    const std::size_t inner = suite.EnterScope(NULL, "inner");
+    suite.ExitScope(inner, 1.0);
+    suite.ExitScope(outer, 1.5);
+  }
+  suite.AddCase("inner", 2.0);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(3u, chart.size());
+  EXPECT_EQ("outer", chart[0].name);
+  EXPECT_EQ(kNoParent, chart[0].parent);
+  EXPECT_DOUBLE_EQ(4.5, chart[0].time);
+  EXPECT_EQ("inner", chart[1].name);
+  EXPECT_EQ(0u, chart[1].parent);
+  EXPECT_DOUBLE_EQ(3.0, chart[1].time);
+  EXPECT_EQ("inner", chart[2].name);
+  EXPECT_EQ(kNoParent, chart[2].parent);
+  EXPECT_EQ(0u, BenchmarkScopeStack::depth);
+}
+
+TEST(BenchmarkSuiteTest, SitesAreCachedPerParent) {
+  BenchmarkSuite suite("suite");
+  BenchmarkCaseSite site = { 0 };
+  const std::size_t outer = suite.EnterScope(NULL, "outer");
+  EXPECT_EQ(1u, suite.EnterScope(&site, "a"));
+  suite.ExitScope(1, 0.0);
+  suite.ExitScope(outer, 0.0);
+  EXPECT_EQ(2u, suite.EnterScope(&site, "a"));
+  suite.ExitScope(2, 0.0);
+  EXPECT_EQ(2u, suite.GetCaseId(site, "a"));
+}
+
+TEST(BenchmarkSuiteTest, UnclosedScopesAreDiscarded) {
+  BenchmarkSuite suite("suite");
+  const std::size_t outer = suite.EnterScope(NULL, "outer");
+  suite.EnterScope(NULL, "leaked");
+  suite.ExitScope(outer, 1.0);
+  EXPECT_EQ(0u, BenchmarkScopeStack::depth);
+  EXPECT_EQ(kNoParent,
+            suite.GetChart()[suite.EnterScope(NULL, "next")].parent);
+  EXPECT_EQ(1u, BenchmarkScopeStack::depth);
+  BenchmarkScopeStack::depth = 0;
+}
+
+TEST(BenchmarkSuiteTest, PrintNestedChart) {
+  SetDefaultLoggerLevel(WARN);
+  BenchmarkSuite suite("suite");
+  BENCHMARK(suite, outer) {
+    BENCHMARK(suite, inner) {
+    }
+  }
+  SetDefaultLoggerLevel(INFO);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(2u, chart.size());
+  EXPECT_EQ(0u, chart[1].parent);
+  EXPECT_LE(chart[1].time, chart[0].time);
+
+  const std::string printed = suite.PrintChart();
+  EXPECT_NE(std::string::npos, printed.find("self (sec)"));
+  EXPECT_NE(std::string::npos, printed.find("% of total"));
+  EXPECT_NE(std::string::npos, printed.find("\nouter "));
+  EXPECT_NE(std::string::npos, printed.find("\n  inner "));
+}
+
+struct Counter {
+  Counter() : count(0) {}
+
+  void operator()() {
+    ++count;
+  }
+
+  long long count;
+};
+
+void CallCounter(Counter* counter) {
+  (*counter)();
+}
+
+TEST(BenchmarkRunnerTest, Run) {
+  BenchmarkSuite suite("suite");
+  BenchmarkRunner runner(suite);
+  runner.set_num_warmup_runs(2);
+  runner.set_num_runs(5);
+  runner.set_min_sample_time(0.001);
+
+  Counter counter;
+  const long long num_iterations =
+      runner.Run("count", std::tr1::bind(CallCounter, &counter));
+  EXPECT_LT(1, num_iterations);
+  // Calibration runs 1, 2, ..., num_iterations iterations.
+  EXPECT_EQ(num_iterations * 2 - 1 + num_iterations * 7, counter.count);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(1u, chart.size());
+  EXPECT_EQ(5, chart[0].histogram.count());
+  EXPECT_EQ(num_iterations * 5, chart[0].num_iterations);
+  EXPECT_LT(0, chart[0].time);
+}
+
+}  // namespace
+
+}  // namespace LOG
@@ -0,0 +1,48 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BENCHMARK_SWITCH_H_
+#define ELOG_BENCHMARK_SWITCH_H_
+
+#include "safe_bool.h"
+#include "util.h"
+
+namespace LOG {
+
+template <AvoidODR>
+struct BenchmarkSwitchTemplate {
+  static volatile bool is_disabled;  // zero-initialized to enabled
+};
+
+template <AvoidODR N>
+volatile bool BenchmarkSwitchTemplate<N>::is_disabled;
+
+typedef BenchmarkSwitchTemplate<AVOID_ODR> BenchmarkSwitch;
+
+// BENCHMARK scopes started while disabled cost a single branch: they neither
+// measure, log, trace nor record in suites, but the clauses are executed.
+inline void SetBenchmarkEnabled(bool enabled) {
+  BenchmarkSwitch::is_disabled = !enabled;
+}
+
+inline bool IsBenchmarkEnabled() {
+  return !BenchmarkSwitch::is_disabled;
+}
+
+// BENCHMARK scope removed by ELOG_DISABLE_BENCHMARK.
+class NullBenchmark : public SafeBool<NullBenchmark> {
+ public:
+  bool BoolTest() const {
+    return false;
+  }
+
+  double GetTime() const {
+    return 0;
+  }
+
+  void Print() {}
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_BENCHMARK_SWITCH_H_
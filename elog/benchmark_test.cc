@@ -0,0 +1,188 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "benchmark.h"
+
+namespace LOG {
+
+namespace {
+
+class SomeModule {};
+
+// Counts the messages pushed to it, including the ones it discards.
+class CountingLogger : public StreamLogger {
+ public:
+  explicit CountingLogger(std::ostream& stream)
+      : StreamLogger(stream),
+        num_messages_(0) {
+  }
+
+  using StreamLogger::PushMessage;
+  using StreamLogger::PushTypedMessage;
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const char* message,
+                           std::size_t message_size) {
+    ++num_messages_;
+    StreamLogger::PushMessage(level, source_file_name, line_number,
+                              message, message_size);
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const char* message,
+                                std::size_t message_size) {
+    ++num_messages_;
+    StreamLogger::PushTypedMessage(type_info, verbosity, source_file_name,
+                                   line_number, message, message_size);
+  }
+
+  int num_messages() const {
+    return num_messages_;
+  }
+
+ private:
+  int num_messages_;
+};
+
+std::size_t CountOccurrences(const std::string& s, const std::string& word) {
+  std::size_t count = 0;
+  for (std::size_t i = s.find(word); i != std::string::npos;
+       i = s.find(word, i + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+}  // anonymous namespace
+
+class BenchmarkTest : public ::testing::Test {
+ public:
+  BenchmarkTest()
+      : logger_(stream_) {
+  }
+
+ protected:
+  virtual void SetUp() {
+    SetLogger(logger_);
+  }
+
+  virtual void TearDown() {
+    UseDefaultLogger();
+    SetBenchmarkEnabled(true);
+    logger_.set_level(INFO);
+    logger_.ResetVerbosities();
+  }
+
+  std::string GetMessage() const {
+    return stream_.str();
+  }
+
+  void SetLevel(LogLevel level) {
+    logger_.set_level(level);
+  }
+
+  void SetVerbosity(int verbosity) {
+    logger_.SetTypeVerbosity(TypeInfo(Type<SomeModule>()), verbosity);
+  }
+
+ private:
+  std::ostringstream stream_;
+  StreamLogger logger_;
+};
+
+TEST_F(BenchmarkTest, Enabled) {
+  int count = 0;
+  BENCHMARK(bench) {
+    ++count;
+    EXPECT_LE(0, bench.GetTime());
+  }
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1u, CountOccurrences(GetMessage(), "bench: start..."));
+  EXPECT_EQ(1u, CountOccurrences(GetMessage(), " sec"));
+}
+
+TEST_F(BenchmarkTest, Disabled) {
+  BenchmarkSuite suite("suite");
+  SetBenchmarkEnabled(false);
+  int count = 0;
+  BENCHMARK(bench) {
+    ++count;
+    EXPECT_EQ(0, bench.GetTime());
+  }
+  BENCHMARK(suite, bench_in_suite) {
+    ++count;
+  }
+  BENCHMARK(SomeModule, 0, typed_bench) {
+    ++count;
+  }
+  BENCHMARK(suite, SomeModule, 0, typed_bench_in_suite) {
+    ++count;
+  }
+  EXPECT_EQ(4, count);
+  EXPECT_EQ("", GetMessage());
+  EXPECT_TRUE(suite.GetChart().empty());
+}
+
+TEST_F(BenchmarkTest, LevelNotHighEnough) {
+  SetLevel(WARN);
+  int count = 0;
+  BENCHMARK(bench) {
+    ++count;
+    EXPECT_EQ(0, bench.GetTime());
+  }
+  EXPECT_EQ(1, count);
+  EXPECT_EQ("", GetMessage());
+}
+
+TEST_F(BenchmarkTest, VerbosityNotLowEnough) {
+  SetVerbosity(1);
+  int count = 0;
+  BENCHMARK(SomeModule, 2, bench) {
+    ++count;
+    EXPECT_EQ(0, bench.GetTime());
+  }
+  BENCHMARK(SomeModule, 1, logged_bench) {
+    ++count;
+  }
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(std::string::npos, GetMessage().find(" bench: start..."));
+  EXPECT_EQ(1u, CountOccurrences(GetMessage(), "logged_bench: start..."));
+}
+
+TEST_F(BenchmarkTest, SuiteIsRecordedRegardlessOfLevel) {
+  SetLevel(WARN);
+  BenchmarkSuite suite("suite");
+  BENCHMARK(suite, bench) {
+  }
+  EXPECT_EQ(1u, suite.GetChart().size());
+}
+
+TEST_F(BenchmarkTest, DiscardedMessagesAreNotBuilt) {
+  std::ostringstream stream;
+  CountingLogger logger(stream);
+  logger.set_level(WARN);
+  logger.SetTypeVerbosity(TypeInfo(Type<SomeModule>()), 0);
+  SetLogger(logger);
+  BenchmarkSuite suite("suite");
+  BENCHMARK(suite, bench) {
+  }
+  BENCHMARK(suite, SomeModule, 1, typed_bench) {
+  }
+  BENCHMARK(suite, SomeModule, 0, logged_bench) {
+  }
+  UseDefaultLogger();
+
+  EXPECT_EQ(3u, suite.GetChart().size());
+  EXPECT_EQ(2, logger.num_messages());
+  EXPECT_EQ(1u, CountOccurrences(stream.str(), "logged_bench: start..."));
+}
+
+}  // namespace LOG
@@ -0,0 +1,270 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BENCHMARK_TRACE_H_
+#define ELOG_BENCHMARK_TRACE_H_
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "atomic.h"
+#include "benchmark_export.h"
+#include "clock.h"
+#include "mutex.h"
+#include "singleton.h"
+#include "thread.h"
+#include "util.h"
+
+namespace LOG {
+
+// Begin or end of a BENCHMARK scope.
+struct BenchmarkTraceEvent {
+  static const std::size_t kMaxNameSize = 48;
+
+  long long time;  // nanoseconds since the tracer was created
+  std::size_t thread_index;  // GetThreadIndex()
+  char phase;  // 'B' or 'E'
+  char name[kMaxNameSize];  // truncated and null-terminated
+};
+
+template <AvoidODR>
+struct BenchmarkTraceFlagTemplate {
+  static volatile bool enabled;
+};
+
+template <AvoidODR N>
+volatile bool BenchmarkTraceFlagTemplate<N>::enabled;
+
+typedef BenchmarkTraceFlagTemplate<AVOID_ODR> BenchmarkTraceFlag;
+
+// Records the begin and the end of BENCHMARK scopes while tracing, and writes
+// them in the Chrome Trace Event format, which chrome://tracing and Perfetto
+// load. Each thread appends events to its own buffer without locks; the
+// first kMaxNumThreadSlots threads of the process have buffers, and events of
+// other threads are recorded under a lock. The memory grows with the number
+// of events until Clear() is called, which keeps a chunk per buffer. The
+// buffers are never deleted, since threads may push to them at any time,
+// even at exit.
+//
+// Use the tracer via StartBenchmarkTrace() and the functions below.
+class BenchmarkTracer : Noncopyable {
+ public:
+  static const std::size_t kMaxNumThreadSlots = 256;
+  static const std::size_t kChunkSize = 1024;  // events
+
+  BenchmarkTracer()
+      : start_time_(Clock::Now()) {
+    std::fill(buffers_, buffers_ + kMaxNumThreadSlots,
+              static_cast<ThreadBuffer*>(NULL));
+  }
+
+  // Writes the trace to the file, if the name is set. The buffers are left
+  // to the threads still in BENCHMARK scopes.
+  ~BenchmarkTracer() {
+    BenchmarkTraceFlag::enabled = false;
+    Dump();
+  }
+
+  void set_file_name(const std::string& file_name) {
+    MutexLock lock(mutex_);
+    file_name_ = file_name;
+  }
+
+  void Record(char phase, const std::string& name) {
+    BenchmarkTraceEvent event;
+    event.time = Clock::ToNanoSec(Clock::Now() - start_time_);
+    event.thread_index = GetThreadIndex();
+    event.phase = phase;
+    const std::size_t size =
+        std::min(name.size(), BenchmarkTraceEvent::kMaxNameSize - 1);
+    std::memcpy(event.name, name.data(), size);
+    event.name[size] = '\0';
+
+    if (event.thread_index < kMaxNumThreadSlots) {
+      GetThreadBuffer(event.thread_index).Push(event);
+      return;
+    }
+    MutexLock lock(mutex_);
+    overflow_events_.push_back(event);
+  }
+
+  // Events recorded by other threads while writing are not written.
+  void Write(std::ostream& os) const {
+    MutexLock lock(mutex_);
+    os << "{\"traceEvents\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < kMaxNumThreadSlots; ++i) {
+      const ThreadBuffer* buffer = buffers_[i];
+      if (!buffer) continue;
+      // The chunks before the last one are full.
+      const Chunk* const last = buffer->last;
+      const std::size_t last_size = last->size;
+      std::size_t begin = buffer->head_begin;
+      for (const Chunk* chunk = buffer->head; ; chunk = chunk->next) {
+        const std::size_t size = chunk == last ? last_size : kChunkSize;
+        for (std::size_t j = begin; j < size; ++j) {
+          WriteEvent(chunk->events[j], first, os);
+        }
+        if (chunk == last) break;
+        begin = 0;
+      }
+    }
+    for (std::size_t i = 0; i < overflow_events_.size(); ++i) {
+      WriteEvent(overflow_events_[i], first, os);
+    }
+    os << "\n], \"displayTimeUnit\": \"ns\"}\n";
+  }
+
+  // Writes the trace to the file, if the name is set.
+  void Dump() const {
+    std::string file_name;
+    {
+      MutexLock lock(mutex_);
+      file_name = file_name_;
+    }
+    if (file_name.empty()) return;
+    std::ofstream file(file_name.c_str());
+    Write(file);
+  }
+
+  // Discards the events recorded so far. The chunk each thread is filling is
+  // kept, and the ones before it are freed.
+  void Clear() {
+    MutexLock lock(mutex_);
+    for (std::size_t i = 0; i < kMaxNumThreadSlots; ++i) {
+      if (ThreadBuffer* buffer = buffers_[i]) {
+        buffer->Discard();
+      }
+    }
+    overflow_events_.clear();
+  }
+
+ private:
+  // Events are published by the size, after they are written.
+  struct Chunk {
+    Chunk()
+        : size(0),
+          next(NULL) {
+    }
+
+    BenchmarkTraceEvent events[kChunkSize];
+    volatile std::size_t size;
+    Chunk* volatile next;
+  };
+
+  // Pushed only by the thread, which touches no chunk before the last one.
+  // The events from head_begin of the head are written; the head and
+  // head_begin are guarded by the mutex of the tracer.
+  struct ThreadBuffer {
+    ThreadBuffer()
+        : last(new Chunk),
+          head(last),
+          head_begin(0) {
+    }
+
+    void Push(const BenchmarkTraceEvent& event) {
+      Chunk* chunk = last;
+      std::size_t size = chunk->size;
+      if (size == kChunkSize) {
+        Chunk* next = new Chunk;
+        AtomicSet(chunk->next, next);
+        AtomicSet(last, next);
+        chunk = next;
+        size = 0;
+      }
+      chunk->events[size] = event;
+      AtomicSet(chunk->size, size + 1);
+    }
+
+    // Frees the chunks before the last one, and skips the events in it.
+    void Discard() {
+      Chunk* const new_head = last;
+      const std::size_t new_begin = new_head->size;
+      while (head != new_head) {
+        Chunk* const next = head->next;
+        delete head;
+        head = next;
+      }
+      head_begin = new_begin;
+    }
+
+    Chunk* volatile last;
+    Chunk* head;
+    std::size_t head_begin;
+  };
+
+  // Called by the thread of the index.
+  ThreadBuffer& GetThreadBuffer(std::size_t thread_index) {
+    ThreadBuffer* buffer = buffers_[thread_index];
+    if (!buffer) {
+      buffer = new ThreadBuffer;
+      MutexLock lock(mutex_);  // excludes Clear()
+      AtomicSet(buffers_[thread_index], buffer);
+    }
+    return *buffer;
+  }
+
+  static void WriteEvent(const BenchmarkTraceEvent& event,
+                         bool& first,
+                         std::ostream& os) {
+    os << (first ? "\n  " : ",\n  ") << "{\"name\": ";
+    first = false;
+    WriteJsonString(event.name, os);
+    os << ", \"ph\": \"" << event.phase << "\", \"ts\": "
+       << event.time / 1000 << '.' << std::setfill('0') << std::setw(3)
+       << event.time % 1000 << ", \"pid\": 0, \"tid\": " << event.thread_index
+       << '}';
+  }
+
+  const Clock::Tick start_time_;
+  ThreadBuffer* volatile buffers_[kMaxNumThreadSlots];
+  std::vector<BenchmarkTraceEvent> overflow_events_;
+  std::string file_name_;
+  mutable Mutex mutex_;
+};
+
+inline bool IsBenchmarkTraceEnabled() {
+  return BenchmarkTraceFlag::enabled;
+}
+
+// Starts recording BENCHMARK scopes. If the file name is given, the trace is
+// written to the file at exit and by DumpBenchmarkTrace().
+inline void StartBenchmarkTrace(const std::string& file_name = "") {
+  Singleton<BenchmarkTracer>::Get().set_file_name(file_name);
+  BenchmarkTraceFlag::enabled = true;
+}
+
+// Scopes already begun are still ended in the trace.
+inline void StopBenchmarkTrace() {
+  BenchmarkTraceFlag::enabled = false;
+}
+
+inline void WriteBenchmarkTrace(std::ostream& os) {
+  Singleton<BenchmarkTracer>::Get().Write(os);
+}
+
+inline void DumpBenchmarkTrace() {
+  Singleton<BenchmarkTracer>::Get().Dump();
+}
+
+inline void ClearBenchmarkTrace() {
+  Singleton<BenchmarkTracer>::Get().Clear();
+}
+
+// Used by BENCHMARK scopes.
+inline void BeginBenchmarkTrace(const std::string& name) {
+  Singleton<BenchmarkTracer>::Get().Record('B', name);
+}
+
+inline void EndBenchmarkTrace(const std::string& name) {
+  Singleton<BenchmarkTracer>::Get().Record('E', name);
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_BENCHMARK_TRACE_H_
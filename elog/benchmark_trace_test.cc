@@ -0,0 +1,189 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include "config.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include <gtest/gtest.h>
+#include "benchmark.h"
+#include "benchmark_trace.h"
+#include "logger_factory.h"
+#include "thread.h"
+
+namespace LOG {
+
+namespace {
+
+std::size_t CountOccurrences(const std::string& s, const std::string& word) {
+  std::size_t count = 0;
+  for (std::size_t i = s.find(word); i != std::string::npos;
+       i = s.find(word, i + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+class BenchmarkTraceTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    SetDefaultLoggerLevel(WARN);
+    ClearBenchmarkTrace();
+  }
+
+  virtual void TearDown() {
+    StopBenchmarkTrace();
+    ClearBenchmarkTrace();
+    SetDefaultLoggerLevel(INFO);
+  }
+
+  static std::string GetTrace() {
+    std::ostringstream stream;
+    WriteBenchmarkTrace(stream);
+    return stream.str();
+  }
+};
+
+TEST_F(BenchmarkTraceTest, DisabledByDefault) {
+  EXPECT_FALSE(IsBenchmarkTraceEnabled());
+  BENCHMARK(untraced) {
+  }
+  EXPECT_EQ(0u, CountOccurrences(GetTrace(), "\"ph\""));
+}
+
+TEST_F(BenchmarkTraceTest, NestedScopes) {
+  StartBenchmarkTrace();
+  BENCHMARK(outer) {
+    BENCHMARK(inner) {
+    }
+  }
+  StopBenchmarkTrace();
+  BENCHMARK(after_stop) {
+  }
+
+  const std::string trace = GetTrace();
+  EXPECT_EQ(0u, trace.find("{\"traceEvents\": ["));
+  EXPECT_EQ(2u, CountOccurrences(trace, "\"ph\": \"B\""));
+  EXPECT_EQ(2u, CountOccurrences(trace, "\"ph\": \"E\""));
+  const std::size_t outer_begin = trace.find("\"outer\", \"ph\": \"B\"");
+  const std::size_t inner_begin = trace.find("\"inner\", \"ph\": \"B\"");
+  const std::size_t inner_end = trace.find("\"inner\", \"ph\": \"E\"");
+  const std::size_t outer_end = trace.find("\"outer\", \"ph\": \"E\"");
+  ASSERT_NE(std::string::npos, outer_begin);
+  EXPECT_LT(outer_begin, inner_begin);
+  EXPECT_LT(inner_begin, inner_end);
+  EXPECT_LT(inner_end, outer_end);
+  EXPECT_EQ(std::string::npos, trace.find("after_stop"));
+}
+
+TEST_F(BenchmarkTraceTest, LongNamesAreTruncated) {
+  StartBenchmarkTrace();
+  BENCHMARK(a_very_long_benchmark_name_which_does_not_fit_in_an_event) {
+  }
+  const std::string trace = GetTrace();
+  EXPECT_NE(std::string::npos,
+            trace.find("\"a_very_long_benchmark_name_which_does_not_fit_i\""));
+}
+
+TEST_F(BenchmarkTraceTest, ManyEvents) {
+  StartBenchmarkTrace();
+  for (std::size_t i = 0; i < BenchmarkTracer::kChunkSize * 2; ++i) {
+    BENCHMARK(loop) {
+    }
+  }
+  EXPECT_EQ(BenchmarkTracer::kChunkSize * 4,
+            CountOccurrences(GetTrace(), "\"loop\""));
+}
+
+void RunBenchmarks() {
+  for (int i = 0; i < 10; ++i) {
+    BENCHMARK(in_thread) {
+    }
+  }
+}
+
+void RunBenchmarksUntilStopped(volatile bool* is_stopped) {
+  while (!*is_stopped) {
+    BENCHMARK(in_thread) {
+    }
+  }
+}
+
+TEST_F(BenchmarkTraceTest, Threads) {
+  static const int kNumThreads = 4;
+
+  StartBenchmarkTrace();
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(RunBenchmarks));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  const std::string trace = GetTrace();
+  EXPECT_EQ(kNumThreads * 20u, CountOccurrences(trace, "\"in_thread\""));
+  EXPECT_EQ(kNumThreads * 20u, CountOccurrences(trace, "\"tid\""));
+}
+
+TEST_F(BenchmarkTraceTest, ClearKeepsLaterEvents) {
+  StartBenchmarkTrace();
+  for (std::size_t i = 0; i < BenchmarkTracer::kChunkSize + 10; ++i) {
+    BENCHMARK(before) {
+    }
+  }
+  ClearBenchmarkTrace();
+  for (int i = 0; i < 3; ++i) {
+    BENCHMARK(after) {
+    }
+  }
+
+  const std::string trace = GetTrace();
+  EXPECT_EQ(0u, CountOccurrences(trace, "\"before\""));
+  EXPECT_EQ(6u, CountOccurrences(trace, "\"after\""));
+}
+
+TEST_F(BenchmarkTraceTest, ClearWhileRecording) {
+  StartBenchmarkTrace();
+  volatile bool is_stopped = false;
+  Thread thread(std::tr1::bind(RunBenchmarksUntilStopped, &is_stopped));
+  thread.Run();
+  for (int i = 0; i < 1000; ++i) {
+    ClearBenchmarkTrace();
+    GetTrace();
+  }
+  is_stopped = true;
+  thread.Join();
+
+  ClearBenchmarkTrace();
+  EXPECT_EQ(0u, CountOccurrences(GetTrace(), "\"in_thread\""));
+}
+
+TEST_F(BenchmarkTraceTest, Dump) {
+  const std::string file_name = "benchmark_trace_test.json";
+  StartBenchmarkTrace(file_name);
+  BENCHMARK(dumped) {
+  }
+  DumpBenchmarkTrace();
+
+  std::ifstream file(file_name.c_str());
+  std::ostringstream content;
+  content << file.rdbuf();
+  EXPECT_EQ(GetTrace(), content.str());
+  std::remove(file_name.c_str());
+  StartBenchmarkTrace();  // not to write the file at exit
+}
+
+}  // namespace
+
+}  // namespace LOG
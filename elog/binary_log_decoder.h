@@ -0,0 +1,231 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BINARY_LOG_DECODER_H_
+#define ELOG_BINARY_LOG_DECODER_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "binary_logger.h"
+#include "binary_stream.h"
+#include "logger.h"
+#include "util.h"
+
+namespace LOG {
+
+struct BinaryLogFormatError : virtual std::exception {};
+
+// Renders binary logs written by BinaryLogger in the text format of
+// StreamLogger. Throws BinaryLogFormatError on broken or foreign input.
+class BinaryLogDecoder : Noncopyable {
+ public:
+  explicit BinaryLogDecoder(std::istream& stream)
+      : stream_(stream),
+        prints_timestamp_(false) {
+  }
+
+  // If true, each message is prefixed by the time it was written in seconds.
+  void set_prints_timestamp(bool prints_timestamp) {
+    prints_timestamp_ = prints_timestamp;
+  }
+
+  void Decode(std::ostream& output) {
+    ReadHeader();
+    for (;;) {
+      unsigned char kind;
+      if (!stream_.read(reinterpret_cast<char*>(&kind), 1)) break;
+      switch (kind) {
+        case BINARY_SITE_RECORD:
+          ReadSiteRecord();
+          break;
+        case BINARY_EVENT_RECORD:
+          ReadEventRecord(output);
+          break;
+        default:
+          throw BinaryLogFormatError();
+      }
+    }
+  }
+
+ private:
+  static const std::size_t kMaxSiteIdGap = 1 << 16;
+
+  struct Site {
+    Site()
+        : is_defined(false),
+          is_typed(false),
+          level(INFO),
+          line_number(0) {
+    }
+
+    bool is_defined;
+    bool is_typed;
+    LogLevel level;
+    std::string type_name;
+    std::string source_file_name;
+    int line_number;
+  };
+
+  template <typename T>
+  T ReadRaw() {
+    T value;
+    if (!stream_.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+      throw BinaryLogFormatError();
+    }
+    return value;
+  }
+
+  std::string ReadString() {
+    const unsigned int length = ReadRaw<unsigned int>();
+    std::string string(length, '\0');
+    if (length && !stream_.read(&string[0], length)) {
+      throw BinaryLogFormatError();
+    }
+    return string;
+  }
+
+  void ReadHeader() {
+    char magic[sizeof(BinaryLogFormat::magic)];
+    if (!stream_.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, BinaryLogFormat::magic, sizeof(magic)) != 0 ||
+        ReadRaw<unsigned int>() != kBinaryLogByteOrderMark) {
+      throw BinaryLogFormatError();
+    }
+  }
+
+  // Site ids are assigned in order from one, so a log defines them with small
+  // gaps. Larger ids are rejected before allocating the table for them.
+  void ReadSiteRecord() {
+    const std::size_t id = ReadRaw<unsigned int>();
+    if (id >= sites_.size()) {
+      if (id - sites_.size() >= kMaxSiteIdGap) throw BinaryLogFormatError();
+      sites_.resize(id + 1);
+    }
+    Site& site = sites_[id];
+    site.is_typed = ReadRaw<unsigned char>() != 0;
+    const unsigned char level = ReadRaw<unsigned char>();
+    if (level > CHECK) throw BinaryLogFormatError();
+    site.level = static_cast<LogLevel>(level);
+    site.type_name = ReadString();
+    site.source_file_name = ReadString();
+    site.line_number = ReadRaw<int>();
+    site.is_defined = true;
+  }
+
+  void ReadEventRecord(std::ostream& output) {
+    const unsigned int id = ReadRaw<unsigned int>();
+    if (id >= sites_.size() || !sites_[id].is_defined) {
+      throw BinaryLogFormatError();
+    }
+    const Site& site = sites_[id];
+    const double timestamp = ReadRaw<double>();
+    const int verbosity = ReadRaw<int>();
+    const std::string arguments = ReadString();
+
+    if (prints_timestamp_) {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.6f ", timestamp);
+      output << buffer;
+    }
+    if (site.is_typed) {
+      output << "[" << site.type_name << "(" << verbosity << ")] ";
+    } else {
+      Logger::OutputLogLevelName(site.level, output);
+    }
+    Logger::OutputFileLine(site.source_file_name.c_str(), site.line_number,
+                           output);
+    RenderArguments(arguments, output);
+    output << std::endl;
+  }
+
+  static void RenderArguments(const std::string& arguments,
+                              std::ostream& output) {
+    const char* itr = arguments.data();
+    const char* const end = itr + arguments.size();
+    while (itr != end) {
+      switch (*itr++) {
+        case BINARY_BOOL:
+          output << (Take<char>(itr, end) != 0);
+          break;
+        case BINARY_CHAR:
+          output << Take<char>(itr, end);
+          break;
+        case BINARY_INT32:
+          output << Take<int>(itr, end);
+          break;
+        case BINARY_UINT32:
+          output << Take<unsigned int>(itr, end);
+          break;
+        case BINARY_INT64:
+          output << Take<long long>(itr, end);
+          break;
+        case BINARY_UINT64:
+          output << Take<unsigned long long>(itr, end);
+          break;
+        case BINARY_FLOAT:
+          output << Take<float>(itr, end);
+          break;
+        case BINARY_DOUBLE:
+          output << Take<double>(itr, end);
+          break;
+        case BINARY_POINTER:
+          output << reinterpret_cast<const void*>(static_cast<std::size_t>(
+              Take<unsigned long long>(itr, end)));
+          break;
+        case BINARY_STRING: {
+          const unsigned int length = Take<unsigned int>(itr, end);
+          if (static_cast<std::size_t>(end - itr) < length) {
+            throw BinaryLogFormatError();
+          }
+          output.write(itr, length);
+          itr += length;
+          break;
+        }
+        case BINARY_PAIR_BEGIN:
+          PutPairBegin(output);
+          break;
+        case BINARY_PAIR_SEPARATOR:
+          PutPairSeparator(output);
+          break;
+        case BINARY_PAIR_END:
+          PutPairEnd(output);
+          break;
+        case BINARY_SEQUENCE_BEGIN:
+          PutSequenceBegin(output);
+          break;
+        case BINARY_SEQUENCE_SEPARATOR:
+          PutSequenceSeparator(output);
+          break;
+        case BINARY_SEQUENCE_END:
+          PutSequenceEnd(output);
+          break;
+        default:
+          throw BinaryLogFormatError();
+      }
+    }
+  }
+
+  template <typename T>
+  static T Take(const char*& itr, const char* end) {
+    if (static_cast<std::size_t>(end - itr) < sizeof(T)) {
+      throw BinaryLogFormatError();
+    }
+    T value;
+    std::memcpy(&value, itr, sizeof(T));
+    itr += sizeof(T);
+    return value;
+  }
+
+  std::istream& stream_;
+  bool prints_timestamp_;
+  std::vector<Site> sites_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_BINARY_LOG_DECODER_H_
@@ -0,0 +1,402 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BINARY_LOGGER_H_
+#define ELOG_BINARY_LOGGER_H_
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "atomic.h"
+#include "binary_stream.h"
+#include "elog.h"
+#include "logger.h"
+#include "logger_factory.h"
+#include "mutex.h"
+#include "timer.h"
+#include "type_info.h"
+#include "util.h"
+#include "verbosity_table.h"
+
+namespace LOG {
+
+// Layout of binary logs. All numbers are in the native byte order.
+//
+//   file:         "ELOGBIN1", uint32 kBinaryLogByteOrderMark, record*
+//   site record:  uint8 BINARY_SITE_RECORD, uint32 site id,
+//                 uint8 is typed, uint8 log level, string type name,
+//                 string source file name, int32 line number
+//   event record: uint8 BINARY_EVENT_RECORD, uint32 site id,
+//                 double timestamp in seconds, int32 verbosity,
+//                 uint32 size of arguments, arguments
+//   string:       uint32 length, characters
+//
+// The arguments are the values written by BinaryStream. The site record of
+// each site precedes its first event record.
+enum BinaryRecordKind {
+  BINARY_SITE_RECORD = 1,
+  BINARY_EVENT_RECORD
+};
+
+template <AvoidODR>
+struct BinaryLogFormatTemplate {
+  static const char magic[8];
+};
+
+template <AvoidODR N>
+const char BinaryLogFormatTemplate<N>::magic[8] = {
+  'E', 'L', 'O', 'G', 'B', 'I', 'N', '1'
+};
+
+typedef BinaryLogFormatTemplate<AVOID_ODR> BinaryLogFormat;
+
+const unsigned int kBinaryLogByteOrderMark = 0x01020304;
+
+// Descriptor of each BLOG() statement, which is written to the log once
+// instead of the file name, line number, level and type of every message.
+// It is a POD initialized at compile time; the id is assigned the first time
+// the statement runs.
+struct BinaryLogSite {
+  LogLevel level;
+  TypeInfo (*get_type_info)();  // NULL for BLOG(level)
+
+  volatile std::size_t id;  // zero if not assigned yet
+  const char* source_file_name;
+  int line_number;
+};
+
+template <AvoidODR>
+struct BinaryLogSiteCountTemplate {
+  static volatile std::size_t value;
+};
+
+template <AvoidODR N>
+volatile std::size_t BinaryLogSiteCountTemplate<N>::value;
+
+typedef BinaryLogSiteCountTemplate<AVOID_ODR> BinaryLogSiteCount;
+
+inline std::size_t GetBinaryLogSiteId(BinaryLogSite& site,
+                                      const char* source_file_name,
+                                      int line_number) {
+  const std::size_t id = site.id;
+  if (id) return id;
+
+  site.source_file_name = source_file_name;
+  site.line_number = line_number;
+  AtomicFence();
+  const std::size_t new_id = FetchAndAdd(BinaryLogSiteCount::value, 1) + 1;
+  const std::size_t old_id = CompareAndSwap(site.id, 0, new_id);
+  return old_id ? old_id : new_id;
+}
+
+template <LogLevel LEVEL, typename TranslationUnit, int LINE>
+struct GeneralBinaryLogSiteHolder {
+  static BinaryLogSite site;
+};
+
+template <LogLevel LEVEL, typename TranslationUnit, int LINE>
+BinaryLogSite GeneralBinaryLogSiteHolder<LEVEL, TranslationUnit, LINE>::site = {
+  LEVEL, NULL, 0, NULL, 0
+};
+
+template <typename T, typename TranslationUnit, int LINE>
+struct TypedBinaryLogSiteHolder {
+  static TypeInfo GetTypeInfo() {
+    return TypeInfo(Type<T>());
+  }
+
+  static BinaryLogSite site;
+};
+
+template <typename T, typename TranslationUnit, int LINE>
+BinaryLogSite TypedBinaryLogSiteHolder<T, TranslationUnit, LINE>::site = {
+  INFO, &TypedBinaryLogSiteHolder<T, TranslationUnit, LINE>::GetTypeInfo,
+  0, NULL, 0
+};
+
+// Writer of binary logs. Messages are recorded without formatting their
+// arguments as text; elog_decode renders the log in the format of
+// StreamLogger. The stream should be opened in binary mode.
+class BinaryLogger : Noncopyable {
+ public:
+  explicit BinaryLogger(std::ostream& stream)
+      : stream_(stream),
+        level_(INFO) {
+    stream_.write(BinaryLogFormat::magic, sizeof(BinaryLogFormat::magic));
+    WriteRaw(kBinaryLogByteOrderMark);
+  }
+
+  LogLevel level() const {
+    return level_;
+  }
+
+  void set_level(LogLevel level) {
+    level_ = level;
+  }
+
+  bool IsLevelEnabled(LogLevel log_level) const {
+    return IsLogLevelSevereEnough(log_level, level_);
+  }
+
+  template <typename T>
+  void SetTypeVerbosity(int verbosity) {
+    SetTypeVerbosity(TypeInfo(Type<T>()), verbosity);
+  }
+
+  void SetTypeVerbosity(TypeInfo type_info, int verbosity) {
+    verbosities_.Set(type_info, verbosity);
+  }
+
+  void ResetVerbosities() {
+    verbosities_.Clear();
+  }
+
+  int GetTypeVerbosity(TypeInfo type_info) const {
+    return verbosities_.Get(type_info);
+  }
+
+  void Flush() {
+    MutexLock lock(mutex_);
+    stream_.flush();
+  }
+
+  // Writes a message of the site. Messages of FATAL and CHECK sites are
+  // flushed, and then FatalLogError and CheckError are thrown respectively.
+  void PushRecord(BinaryLogSite& site,
+                  int verbosity,
+                  const char* source_file_name,
+                  int line_number,
+                  const BinaryStream& arguments) {
+    const std::size_t id =
+        GetBinaryLogSiteId(site, source_file_name, line_number);
+    const double timestamp = GetTimeSec();
+    {
+      MutexLock lock(mutex_);
+      if (id >= defined_sites_.size()) {
+        defined_sites_.resize(id + 1);
+      }
+      if (!defined_sites_[id]) {
+        WriteSiteRecord(site, id);
+        defined_sites_[id] = true;
+      }
+
+      WriteRaw(static_cast<unsigned char>(BINARY_EVENT_RECORD));
+      WriteRaw(static_cast<unsigned int>(id));
+      WriteRaw(timestamp);
+      WriteRaw(verbosity);
+      WriteRaw(static_cast<unsigned int>(arguments.size()));
+      stream_.write(arguments.data(), arguments.size());
+      if (!site.get_type_info && site.level >= FATAL) {
+        stream_.flush();
+      }
+    }
+
+    if (!site.get_type_info) {
+      if (site.level == FATAL) throw FatalLogError();
+      if (site.level == CHECK) throw CheckError();
+    }
+  }
+
+ private:
+  template <typename T>
+  void WriteRaw(const T& value) {
+    stream_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void WriteString(const char* s) {
+    const std::string string(s ? s : "");
+    WriteRaw(static_cast<unsigned int>(string.size()));
+    stream_.write(string.data(), string.size());
+  }
+
+  void WriteSiteRecord(const BinaryLogSite& site, std::size_t id) {
+    WriteRaw(static_cast<unsigned char>(BINARY_SITE_RECORD));
+    WriteRaw(static_cast<unsigned int>(id));
+    WriteRaw(static_cast<unsigned char>(site.get_type_info != NULL));
+    WriteRaw(static_cast<unsigned char>(site.level));
+    if (site.get_type_info) {
+      WriteString(site.get_type_info().GetName());
+    } else {
+      WriteString("");
+    }
+    WriteString(site.source_file_name);
+    WriteRaw(site.line_number);
+  }
+
+  std::ostream& stream_;
+  volatile LogLevel level_;
+  VerbosityTable verbosities_;
+  std::vector<bool> defined_sites_;
+  Mutex mutex_;
+};
+
+template <AvoidODR>
+struct BinaryLoggerHolderTemplate {
+  static BinaryLogger* volatile logger;
+};
+
+template <AvoidODR N>
+BinaryLogger* volatile BinaryLoggerHolderTemplate<N>::logger;
+
+typedef BinaryLoggerHolderTemplate<AVOID_ODR> BinaryLoggerHolder;
+
+// Returns NULL if no binary logger is set, in which case BLOG() writes
+// nothing.
+inline BinaryLogger* GetBinaryLogger() {
+  return BinaryLoggerHolder::logger;
+}
+
+inline void SetBinaryLogger(BinaryLogger& logger) {
+  AtomicSet(BinaryLoggerHolder::logger, &logger);
+}
+
+inline void ResetBinaryLogger() {
+  AtomicSet(BinaryLoggerHolder::logger, static_cast<BinaryLogger*>(NULL));
+}
+
+// Returns the binary logger if it writes the level, and NULL otherwise. BLOG()
+// loads the logger once by this and writes to it, so that ResetBinaryLogger()
+// in between does not leave it with NULL.
+inline BinaryLogger* GetBinaryLoggerOfLevel(LogLevel level) {
+  BinaryLogger* logger = GetBinaryLogger();
+  return logger && (level >= FATAL || logger->IsLevelEnabled(level)) ?
+      logger : NULL;
+}
+
+inline BinaryLogger* GetBinaryLoggerOfType(TypeInfo type_info,
+                                           int verbosity) {
+  BinaryLogger* logger = GetBinaryLogger();
+  return logger &&
+      !IsVerboseEnough(verbosity, logger->GetTypeVerbosity(type_info)) ?
+      logger : NULL;
+}
+
+inline bool IsBinaryLogLevelEnabled(LogLevel level) {
+  return GetBinaryLoggerOfLevel(level) != NULL;
+}
+
+inline bool IsTypedBinaryLogEnabled(TypeInfo type_info, int verbosity) {
+  return GetBinaryLoggerOfType(type_info, verbosity) != NULL;
+}
+
+// Loop state of BLOG(). The body runs once if the binary logger writes the
+// message, and also without the logger for FATAL so that BLOG(FATAL) throws as
+// LOG(FATAL) does.
+class BinaryLogLoop {
+ public:
+  BinaryLogLoop(BinaryLogger* logger, bool is_fatal)
+      : logger_(logger),
+        is_active_(logger || is_fatal) {
+  }
+
+  BinaryLogger* logger() const {
+    return logger_;
+  }
+
+  bool is_active() const {
+    return is_active_;
+  }
+
+  void Stop() {
+    is_active_ = false;
+  }
+
+ private:
+  BinaryLogger* logger_;
+  bool is_active_;
+};
+
+// Without the binary logger, which happens only for FATAL and CHECK, the
+// message goes to the text logger with its location, since the arguments are
+// not rendered as text.
+class BinaryLog {
+ public:
+  BinaryLog(BinaryLogger* logger,
+            BinaryLogSite& site,
+            int verbosity,
+            const char* source_file_name,
+            int line_number)
+      : logger_(logger),
+        site_(site),
+        verbosity_(verbosity),
+        source_file_name_(source_file_name),
+        line_number_(line_number) {
+  }
+
+  BinaryLog(const BinaryLog& binary_log)
+      : logger_(binary_log.logger_),
+        site_(binary_log.site_),
+        verbosity_(binary_log.verbosity_),
+        source_file_name_(binary_log.source_file_name_),
+        line_number_(binary_log.line_number_) {
+  }
+
+  template <typename T>
+  BinaryLog& operator<<(const T& t) {
+    PutAsString(t, stream_);
+    return *this;
+  }
+
+  BinaryLog& GetReference() {
+    return *this;
+  }
+
+  void PushMessage() const {
+    if (logger_) {
+      logger_->PushRecord(site_, verbosity_, source_file_name_, line_number_,
+                          stream_);
+    } else if (site_.level == CHECK) {
+      GetLogger().PushCheckMessageAndThrow(source_file_name_, line_number_,
+                                           std::string());
+    } else {
+      GetLogger().PushFatalMessageAndThrow(source_file_name_, line_number_,
+                                           std::string());
+    }
+  }
+
+ private:
+  BinaryLogger* logger_;
+  BinaryLogSite& site_;
+  BinaryStream stream_;
+  int verbosity_;
+  const char* source_file_name_;
+  int line_number_;
+};
+
+}  // namespace LOG
+
+// Same as LOG(), but writes to the binary logger. Nothing is written unless
+// SetBinaryLogger() is called, except that BLOG(FATAL) still throws. Unlike
+// LOG(), it is a statement rather than an expression.
+#define BLOG(...) ELOG_I_OVERLOAD(ELOG_I_BLOG_, __VA_ARGS__)
+
+#define ELOG_I_BLOG_0() ELOG_I_BLOG_1(INFO)
+
+#define ELOG_I_BLOG_1(level) \
+  for (::LOG::BinaryLogLoop elog_i_binary_log_loop( \
+           ::LOG::GeneralLog< ::LOG::level>::kIsCompiledIn ? \
+           ::LOG::GetBinaryLoggerOfLevel(::LOG::level) : NULL, \
+           ::LOG::level >= ::LOG::FATAL); \
+       elog_i_binary_log_loop.is_active(); elog_i_binary_log_loop.Stop()) \
+    ::LOG::LogEmitTrigger() & \
+    ::LOG::BinaryLog(elog_i_binary_log_loop.logger(), \
+                     ::LOG::GeneralBinaryLogSiteHolder< \
+                         ::LOG::level, ::LOG::TranslationUnitTag, \
+                         ELOG_I_LINE>::site, \
+                     0, ELOG_I_FILE, ELOG_I_LINE).GetReference()
+
+// The verbosity expression is evaluated more than once.
+#define ELOG_I_BLOG_2(type, verbosity) \
+  for (::LOG::BinaryLogger* elog_i_binary_logger = \
+           ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) ? \
+           ::LOG::GetBinaryLoggerOfType( \
+               ::LOG::TypeInfo(::LOG::Type<type>()), (verbosity)) : NULL; \
+       elog_i_binary_logger; elog_i_binary_logger = NULL) \
+    ::LOG::LogEmitTrigger() & \
+    ::LOG::BinaryLog(elog_i_binary_logger, \
+                     ::LOG::TypedBinaryLogSiteHolder< \
+                         type, ::LOG::TranslationUnitTag, ELOG_I_LINE>::site, \
+                     (verbosity), ELOG_I_FILE, ELOG_I_LINE).GetReference()
+
+#endif  // ELOG_BINARY_LOGGER_H_
@@ -0,0 +1,73 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the cost of writing a message by LOG() to StreamLogger and by
+// BLOG() to BinaryLogger. Both write to an in-memory stream, which is cleared
+// periodically.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "binary_logger.h"
+#include "elog.h"
+#include "stream_logger.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+const int kClearInterval = 1024;
+
+void PrintThroughput(const char* title, double time, std::size_t size) {
+  std::cout << title << ": " << time * 1e9 / kNumIterations << " ns/message, "
+            << static_cast<double>(size) / kNumIterations << " bytes/message"
+            << std::endl;
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::vector<int> vector;
+  for (int i = 0; i < 8; ++i) {
+    vector.push_back(i * 1000);
+  }
+
+  {
+    std::ostringstream stream;
+    LOG::StreamLogger logger(stream);
+    LOG::SetLogger(logger);
+    std::size_t total_size = 0;
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG(INFO) << "request " << i << " done in " << i * 0.25 << " ms: "
+                << vector;
+      if (i % kClearInterval == 0) {
+        total_size += stream.str().size();
+        stream.str("");
+      }
+    }
+    total_size += stream.str().size();
+    PrintThroughput("LOG", timer.GetTime(), total_size);
+    LOG::UseDefaultLogger();
+  }
+  {
+    std::ostringstream stream;
+    LOG::BinaryLogger logger(stream);
+    LOG::SetBinaryLogger(logger);
+    std::size_t total_size = 0;
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      BLOG(INFO) << "request " << i << " done in " << i * 0.25 << " ms: "
+                 << vector;
+      if (i % kClearInterval == 0) {
+        total_size += stream.str().size();
+        stream.str("");
+      }
+    }
+    total_size += stream.str().size();
+    PrintThroughput("BLOG", timer.GetTime(), total_size);
+    LOG::ResetBinaryLogger();
+  }
+  return 0;
+}
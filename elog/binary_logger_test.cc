@@ -0,0 +1,231 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include "config.h"
+
+#include <climits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include <gtest/gtest.h>
+#include "binary_log_decoder.h"
+#include "binary_logger.h"
+#include "elog.h"
+#include "stream_logger.h"
+#include "thread.h"
+
+namespace LOG {
+
+namespace {
+
+class SomeModule {};
+
+struct Point {
+  int x;
+  int y;
+};
+
+std::ostream& operator<<(std::ostream& os, const Point& point) {
+  return os << '<' << point.x << ' ' << point.y << '>';
+}
+
+void ToggleBinaryLogger(BinaryLogger* logger, volatile bool* is_stopped) {
+  while (!*is_stopped) {
+    SetBinaryLogger(*logger);
+    ResetBinaryLogger();
+  }
+}
+
+std::string Decode(const std::string& binary_log) {
+  std::istringstream input(binary_log);
+  std::ostringstream output;
+  BinaryLogDecoder decoder(input);
+  decoder.Decode(output);
+  return output.str();
+}
+
+// Writes the same statements by LOG() and BLOG(), and returns the outputs of
+// StreamLogger and the decoded binary log.
+std::pair<std::string, std::string> LogBoth() {
+  std::vector<int> vector;
+  vector.push_back(1);
+  vector.push_back(-2);
+  std::map<std::string, double> map;
+  map["a"] = 0.5;
+  map["b"] = 1e100;
+  const Point point = { 3, 4 };
+  const int value = 0;
+
+  std::ostringstream text;
+  StreamLogger stream_logger(text);
+  stream_logger.SetTypeVerbosity<SomeModule>(1);
+  SetLogger(stream_logger);
+
+  std::ostringstream binary;
+  BinaryLogger binary_logger(binary);
+  binary_logger.SetTypeVerbosity<SomeModule>(1);
+  SetBinaryLogger(binary_logger);
+
+  for (int i = 0; i < 2; ++i) {
+    LOG(WARN) << "int " << -12 << ' ' << 34u << ' ' << 5678901234LL
+              << " bool " << true << " double " << 2.5 << ' ' << 1.5f;
+    BLOG(WARN) << "int " << -12 << ' ' << 34u << ' ' << 5678901234LL
+               << " bool " << true << " double " << 2.5 << ' ' << 1.5f;
+  }
+  LOG(ERROR) << vector << ' ' << map << ' ' << point << ' ' << &value;
+  BLOG(ERROR) << vector << ' ' << map << ' ' << point << ' ' << &value;
+  LOG() << LimitPrinting(1) << vector << ' ' << map;
+  BLOG() << LimitPrinting(1) << vector << ' ' << map;
+  LOG(SomeModule, 1) << "typed";
+  BLOG(SomeModule, 1) << "typed";
+  LOG(SomeModule, 2) << "filtered";
+  BLOG(SomeModule, 2) << "filtered";
+  const char* null_string = NULL;
+  LOG() << null_string;
+  BLOG() << null_string;
+
+  ResetBinaryLogger();
+  UseDefaultLogger();
+  return std::make_pair(text.str(), Decode(binary.str()));
+}
+
+// Removes the source line numbers, which differ between LOG and BLOG.
+std::string RemoveLineNumbers(const std::string& log) {
+  std::string result;
+  bool is_in_parentheses = false;
+  for (std::size_t i = 0; i < log.size(); ++i) {
+    if (log.compare(i, 3, ".cc") == 0 && log[i + 3] == '(') {
+      result += ".cc(";
+      i += 3;
+      is_in_parentheses = true;
+    } else if (is_in_parentheses) {
+      if (log[i] == ')') {
+        result += ')';
+        is_in_parentheses = false;
+      }
+    } else {
+      result += log[i];
+    }
+  }
+  return result;
+}
+
+}  // anonymous namespace
+
+TEST(BinaryLoggerTest, DecodedAsStreamLogger) {
+  const std::pair<std::string, std::string> logs = LogBoth();
+  EXPECT_EQ(RemoveLineNumbers(logs.first), RemoveLineNumbers(logs.second));
+  EXPECT_NE(std::string::npos, logs.second.find("1,-2 (a,0.5),(b,1e+100)"));
+  EXPECT_NE(std::string::npos, logs.second.find("<3 4>"));
+  EXPECT_NE(std::string::npos,
+            logs.second.find("1,...(1 more) (a,0.5),...(1 more)"));
+  EXPECT_NE(std::string::npos, logs.second.find("SomeModule(1)] "));
+  EXPECT_NE(std::string::npos, logs.second.find(": (null)\n"));
+  EXPECT_EQ(std::string::npos, logs.second.find("filtered"));
+}
+
+TEST(BinaryLoggerTest, SiteIsWrittenOnce) {
+  std::ostringstream binary;
+  BinaryLogger logger(binary);
+  SetBinaryLogger(logger);
+  std::size_t sizes[3];
+  for (int i = 0; i < 3; ++i) {
+    const std::size_t size = binary.str().size();
+    BLOG() << i;
+    sizes[i] = binary.str().size() - size;
+  }
+  ResetBinaryLogger();
+
+  EXPECT_GT(sizes[0], sizes[1]);
+  EXPECT_EQ(sizes[1], sizes[2]);
+  EXPECT_EQ("[INFO] " __FILE__ "(", Decode(binary.str()).substr(
+      0, sizeof("[INFO] " __FILE__ "(") - 1));
+}
+
+TEST(BinaryLoggerTest, Level) {
+  std::ostringstream binary;
+  BinaryLogger logger(binary);
+  logger.set_level(ERROR);
+  SetBinaryLogger(logger);
+  int count = 0;
+  BLOG(WARN) << ++count;
+  BLOG(ERROR) << ++count;
+  ResetBinaryLogger();
+
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(std::string::npos, Decode(binary.str()).find("[WARN]"));
+}
+
+TEST(BinaryLoggerTest, NoLogger) {
+  int count = 0;
+  BLOG(ERROR) << ++count;
+  EXPECT_EQ(0, count);
+}
+
+TEST(BinaryLoggerTest, LoggerResetConcurrently) {
+  std::ostringstream binary;
+  BinaryLogger logger(binary);
+  volatile bool is_stopped = false;
+  Thread thread(std::tr1::bind(ToggleBinaryLogger, &logger, &is_stopped));
+  thread.Run();
+  for (int i = 0; i < 100000; ++i) {
+    BLOG() << i;
+  }
+  is_stopped = true;
+  thread.Join();
+  ResetBinaryLogger();
+}
+
+TEST(BinaryLoggerTest, Fatal) {
+  std::ostringstream binary;
+  BinaryLogger logger(binary);
+  SetBinaryLogger(logger);
+  EXPECT_THROW(BLOG(FATAL) << "fatal", FatalLogError);
+  ResetBinaryLogger();
+  EXPECT_NE(std::string::npos, Decode(binary.str()).find("[FATAL]"));
+}
+
+TEST(BinaryLoggerTest, FatalWithoutLogger) {
+  std::ostringstream text;
+  StreamLogger stream_logger(text);
+  SetLogger(stream_logger);
+  EXPECT_THROW(BLOG(FATAL) << "fatal", FatalLogError);
+  UseDefaultLogger();
+  EXPECT_NE(std::string::npos, text.str().find("[FATAL]"));
+}
+
+TEST(BinaryLoggerTest, BrokenLog) {
+  std::ostringstream binary;
+  {
+    BinaryLogger logger(binary);
+    SetBinaryLogger(logger);
+    BLOG() << "message";
+    ResetBinaryLogger();
+  }
+  const std::string log = binary.str();
+  EXPECT_THROW(Decode("not a binary log"), BinaryLogFormatError);
+  EXPECT_THROW(Decode(log.substr(0, log.size() - 1)), BinaryLogFormatError);
+}
+
+TEST(BinaryLoggerTest, HugeSiteId) {
+  std::ostringstream binary;
+  {
+    BinaryLogger logger(binary);
+  }
+  const unsigned int ids[] = { 1u << 30, UINT_MAX };
+  for (std::size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+    std::string log = binary.str();
+    log += static_cast<char>(BINARY_SITE_RECORD);
+    log.append(reinterpret_cast<const char*>(&ids[i]), sizeof(ids[i]));
+    EXPECT_THROW(Decode(log), BinaryLogFormatError);
+  }
+}
+
+}  // namespace LOG
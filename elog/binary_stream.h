@@ -0,0 +1,251 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BINARY_STREAM_H_
+#define ELOG_BINARY_STREAM_H_
+
+#include <cstddef>
+#include <cstring>
+#include <ios>
+#include <sstream>
+#include <string>
+#include "message_stream.h"
+#include "put_as_string.h"
+#include "util.h"
+
+namespace LOG {
+
+// Tags of the values in the arguments of binary log records. Each tag is one
+// byte followed by the raw bytes of the value in the native byte order.
+enum BinaryValueTag {
+  BINARY_BOOL = 1,                 // 1 byte
+  BINARY_CHAR,                     // 1 byte
+  BINARY_INT32,                    // 4 bytes
+  BINARY_UINT32,                   // 4 bytes
+  BINARY_INT64,                    // 8 bytes
+  BINARY_UINT64,                   // 8 bytes
+  BINARY_FLOAT,                    // sizeof(float) bytes
+  BINARY_DOUBLE,                   // sizeof(double) bytes
+  BINARY_POINTER,                  // 8 bytes
+  BINARY_STRING,                   // 4 bytes of length and the characters
+  BINARY_PAIR_BEGIN,               // no value
+  BINARY_PAIR_SEPARATOR,           // ditto
+  BINARY_PAIR_END,                 // ditto
+  BINARY_SEQUENCE_BEGIN,           // ditto
+  BINARY_SEQUENCE_SEPARATOR,       // ditto
+  BINARY_SEQUENCE_END              // ditto
+};
+
+// Output stream which records values as tagged raw bytes instead of text.
+// Pairs and containers written by PutAsString() keep their structure. Values
+// of other types are formatted by their operator<< and recorded as strings.
+// Manipulators have no effect. The bytes are built in a MessageStream, so
+// short records do not allocate memory.
+class BinaryStream : Noncopyable {
+ public:
+  const char* data() const {
+    return buffer_.data();
+  }
+
+  std::size_t size() const {
+    return buffer_.size();
+  }
+
+  // Limits of the pairs and containers; bytes are counted in the record.
+  PrintState& print_state() {
+    return buffer_.print_state();
+  }
+
+  void PutTag(BinaryValueTag tag) {
+    buffer_.put(static_cast<char>(tag));
+  }
+
+  template <typename T>
+  void PutRaw(const T& value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer_.write(bytes, sizeof(T));
+  }
+
+  // Records the characters as a string.
+  BinaryStream& write(const char* s, std::size_t n) {
+    PutString(s, n);
+    return *this;
+  }
+
+  void PutString(const char* s, std::size_t n) {
+    PutTag(BINARY_STRING);
+    PutRaw(static_cast<unsigned int>(n));
+    buffer_.write(s, n);
+  }
+
+  BinaryStream& operator<<(bool b) {
+    PutTag(BINARY_BOOL);
+    buffer_.put(b ? 1 : 0);
+    return *this;
+  }
+
+  BinaryStream& operator<<(char c) {
+    PutTag(BINARY_CHAR);
+    buffer_.put(c);
+    return *this;
+  }
+
+  BinaryStream& operator<<(signed char c) {
+    return *this << static_cast<char>(c);
+  }
+
+  BinaryStream& operator<<(unsigned char c) {
+    return *this << static_cast<char>(c);
+  }
+
+  BinaryStream& operator<<(const char* s) {
+    if (!s) {
+      // Same as MessageStream.
+      PutString("(null)", 6);
+      return *this;
+    }
+    PutString(s, std::strlen(s));
+    return *this;
+  }
+
+  BinaryStream& operator<<(const std::string& s) {
+    PutString(s.data(), s.size());
+    return *this;
+  }
+
+  BinaryStream& operator<<(short n) {
+    return PutSigned(n);
+  }
+
+  BinaryStream& operator<<(unsigned short n) {
+    return PutUnsigned(n);
+  }
+
+  BinaryStream& operator<<(int n) {
+    return PutSigned(n);
+  }
+
+  BinaryStream& operator<<(unsigned int n) {
+    return PutUnsigned(n);
+  }
+
+  BinaryStream& operator<<(long n) {
+    return PutSigned(n);
+  }
+
+  BinaryStream& operator<<(unsigned long n) {
+    return PutUnsigned(n);
+  }
+
+  BinaryStream& operator<<(long long n) {
+    return PutSigned(n);
+  }
+
+  BinaryStream& operator<<(unsigned long long n) {
+    return PutUnsigned(n);
+  }
+
+  BinaryStream& operator<<(float x) {
+    PutTag(BINARY_FLOAT);
+    PutRaw(x);
+    return *this;
+  }
+
+  BinaryStream& operator<<(double x) {
+    PutTag(BINARY_DOUBLE);
+    PutRaw(x);
+    return *this;
+  }
+
+  // Recorded as double.
+  BinaryStream& operator<<(long double x) {
+    return *this << static_cast<double>(x);
+  }
+
+  BinaryStream& operator<<(const void* p) {
+    PutTag(BINARY_POINTER);
+    PutRaw(static_cast<unsigned long long>(reinterpret_cast<std::size_t>(p)));
+    return *this;
+  }
+
+  BinaryStream& operator<<(std::ostream& (*)(std::ostream&)) {
+    return *this;
+  }
+
+  BinaryStream& operator<<(std::ios_base& (*)(std::ios_base&)) {
+    return *this;
+  }
+
+  template <typename T>
+  BinaryStream& operator<<(const T& t) {
+    std::ostringstream formatter;
+    formatter << t;
+    const std::string formatted = formatter.str();
+    PutString(formatted.data(), formatted.size());
+    return *this;
+  }
+
+ private:
+  template <typename Signed>
+  BinaryStream& PutSigned(Signed n) {
+    if (sizeof(Signed) <= 4) {
+      PutTag(BINARY_INT32);
+      PutRaw(static_cast<int>(n));
+    } else {
+      PutTag(BINARY_INT64);
+      PutRaw(static_cast<long long>(n));
+    }
+    return *this;
+  }
+
+  template <typename Unsigned>
+  BinaryStream& PutUnsigned(Unsigned n) {
+    if (sizeof(Unsigned) <= 4) {
+      PutTag(BINARY_UINT32);
+      PutRaw(static_cast<unsigned int>(n));
+    } else {
+      PutTag(BINARY_UINT64);
+      PutRaw(static_cast<unsigned long long>(n));
+    }
+    return *this;
+  }
+
+  MessageStream buffer_;
+};
+
+inline void PutPairBegin(BinaryStream& stream) {
+  stream.PutTag(BINARY_PAIR_BEGIN);
+}
+
+inline void PutPairSeparator(BinaryStream& stream) {
+  stream.PutTag(BINARY_PAIR_SEPARATOR);
+}
+
+inline void PutPairEnd(BinaryStream& stream) {
+  stream.PutTag(BINARY_PAIR_END);
+}
+
+inline void PutSequenceBegin(BinaryStream& stream) {
+  stream.PutTag(BINARY_SEQUENCE_BEGIN);
+}
+
+inline void PutSequenceSeparator(BinaryStream& stream) {
+  stream.PutTag(BINARY_SEQUENCE_SEPARATOR);
+}
+
+inline void PutSequenceEnd(BinaryStream& stream) {
+  stream.PutTag(BINARY_SEQUENCE_END);
+}
+
+inline PrintState* GetPrintState(BinaryStream& stream) {
+  return &stream.print_state();
+}
+
+inline std::size_t GetPrintedSize(const BinaryStream& stream) {
+  return stream.size();
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_BINARY_STREAM_H_
@@ -0,0 +1,138 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_BOUNDED_QUEUE_H_
+#define ELOG_BOUNDED_QUEUE_H_
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include "atomic.h"
+#include "util.h"
+
+namespace LOG {
+
+// Bounded lock-free queue which accepts any number of producers and
+// consumers. Each cell carries a sequence number telling whether the cell is
+// ready to be written or read at a given position, so producers and consumers
+// only contend on a CAS of the position counters and never on the elements.
+// Elements are moved in and out by swap, so that T (e.g. a record holding a
+// std::string) can reuse its storage once the queue is warmed up.
+template <typename T>
+class BoundedQueue : Noncopyable {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit BoundedQueue(std::size_t capacity)
+      : cells_(RoundUpToPowerOfTwo(capacity)),
+        mask_(cells_.size() - 1),
+        enqueue_position_(0),
+        dequeue_position_(0) {
+    for (std::size_t i = 0; i < cells_.size(); ++i) {
+      cells_[i].sequence = i;
+    }
+  }
+
+  std::size_t capacity() const {
+    return cells_.size();
+  }
+
+  // Number of positions ever reserved by producers.
+  std::size_t enqueue_position() const {
+    return enqueue_position_;
+  }
+
+  // Number of positions ever reserved by consumers.
+  std::size_t dequeue_position() const {
+    return dequeue_position_;
+  }
+
+  // Swaps t into the queue. Returns false without touching t when full.
+  bool TryPush(T& t) {
+    Cell* cell;
+    std::size_t position = enqueue_position_;
+    for (;;) {
+      cell = &cells_[position & mask_];
+      const std::size_t sequence = cell->sequence;
+      AtomicFence();
+      const std::ptrdiff_t diff =
+          static_cast<std::ptrdiff_t>(sequence - position);
+      if (diff == 0) {
+        const std::size_t old_position =
+            CompareAndSwap(enqueue_position_, position, position + 1);
+        if (old_position == position) break;
+        position = old_position;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = enqueue_position_;
+      }
+    }
+    std::swap(cell->value, t);
+    AtomicFence();
+    cell->sequence = position + 1;
+    return true;
+  }
+
+  // Swaps the oldest element out into t. Returns false when empty.
+  bool TryPop(T& t) {
+    std::size_t position;
+    return TryPop(t, position);
+  }
+
+  // Same as above, and tells the position of the element.
+  bool TryPop(T& t, std::size_t& position) {
+    Cell* cell;
+    position = dequeue_position_;
+    for (;;) {
+      cell = &cells_[position & mask_];
+      const std::size_t sequence = cell->sequence;
+      AtomicFence();
+      const std::ptrdiff_t diff =
+          static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if (diff == 0) {
+        const std::size_t old_position =
+            CompareAndSwap(dequeue_position_, position, position + 1);
+        if (old_position == position) break;
+        position = old_position;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = dequeue_position_;
+      }
+    }
+    std::swap(cell->value, t);
+    AtomicFence();
+    cell->sequence = position + mask_ + 1;
+    return true;
+  }
+
+ private:
+  struct Cell {
+    volatile std::size_t sequence;
+    T value;
+  };
+
+  static std::size_t RoundUpToPowerOfTwo(std::size_t n) {
+    std::size_t power = 2;
+    while (power < n) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  // Producers and consumers write different counters; keep them on different
+  // cache lines.
+  enum { kCacheLineSize = 64 };
+
+  std::vector<Cell> cells_;
+  const std::size_t mask_;
+  char padding0_[kCacheLineSize];
+  volatile std::size_t enqueue_position_;
+  char padding1_[kCacheLineSize];
+  volatile std::size_t dequeue_position_;
+  char padding2_[kCacheLineSize];
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_BOUNDED_QUEUE_H_
@@ -0,0 +1,97 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_CLOCK_H_
+#define ELOG_CLOCK_H_
+
+#include "config.h"
+
+#ifdef _WIN32
+# include "clock_win32.h"
+#else
+# include "clock_posix.h"
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
+# define ELOG_I_HAS_TSC
+# ifdef _MSC_VER
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+# endif
+#endif
+
+#include "atomic.h"
+#include "util.h"
+
+// Clocks measure intervals by the difference of two Now() values, converted
+// by ToNanoSec(). Clock is the one used by Timer and benchmarks.
+
+namespace LOG {
+
+#ifdef ELOG_I_HAS_TSC
+
+template <AvoidODR>
+class TscClockTemplate {
+ public:
+  typedef long long Tick;
+
+  // Reads the time stamp counter of the CPU. Ticks are comparable across
+  // cores only on CPUs with invariant TSC, which most current x86 CPUs have.
+  static Tick Now() {
+    return __rdtsc();
+  }
+
+  // The rate of the counter is calibrated against MonotonicClock on the first
+  // call, which takes about 10 milliseconds.
+  static long long ToNanoSec(Tick ticks) {
+    CallOnce(calibration_flag_, Calibrate);
+    while (nano_sec_per_tick_ == 0) {
+      // Another thread is calibrating.
+    }
+    return static_cast<long long>(ticks * nano_sec_per_tick_);
+  }
+
+ private:
+  static void Calibrate() {
+    static const long long kCalibrationNanoSec = 10000000;
+
+    const MonotonicClock::Tick start_time = MonotonicClock::Now();
+    const Tick start_ticks = Now();
+    long long elapsed_nano_sec;
+    do {
+      elapsed_nano_sec =
+          MonotonicClock::ToNanoSec(MonotonicClock::Now() - start_time);
+    } while (elapsed_nano_sec < kCalibrationNanoSec);
+    const Tick elapsed_ticks = Now() - start_ticks;
+    nano_sec_per_tick_ = static_cast<double>(elapsed_nano_sec) / elapsed_ticks;
+  }
+
+  static OnceFlag calibration_flag_;
+  static volatile double nano_sec_per_tick_;
+};
+
+template <AvoidODR N>
+OnceFlag TscClockTemplate<N>::calibration_flag_;
+
+template <AvoidODR N>
+volatile double TscClockTemplate<N>::nano_sec_per_tick_;
+
+typedef TscClockTemplate<AVOID_ODR> TscClock;
+
+#else  // ifndef ELOG_I_HAS_TSC
+
+typedef MonotonicClock TscClock;
+
+#endif  // ELOG_I_HAS_TSC
+
+#ifdef ELOG_USE_TSC_CLOCK
+typedef TscClock Clock;
+#else
+typedef MonotonicClock Clock;
+#endif
+
+}  // namespace LOG
+
+#endif  // ELOG_CLOCK_H_
@@ -0,0 +1,43 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the cost of reading each clock.
+
+#include <iostream>
+#include "clock.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 10000000;
+
+template <typename ClockType>
+void MeasureClock(const char* title) {
+  LOG::BasicTimer<LOG::MonotonicClock> timer;
+  typename ClockType::Tick sum = 0;
+  for (int i = 0; i < kNumIterations; ++i) {
+    sum += ClockType::Now();
+  }
+  const double nano_sec =
+      static_cast<double>(timer.GetNanoSec()) / kNumIterations;
+  std::cout << title << ": " << nano_sec << " ns/read" << (sum ? "" : " ")
+            << std::endl;
+}
+
+}  // anonymous namespace
+
+int main() {
+  {
+    LOG::BasicTimer<LOG::MonotonicClock> timer;
+    double sum = 0;
+    for (int i = 0; i < kNumIterations; ++i) {
+      sum += LOG::GetTimeSec();
+    }
+    std::cout << "GetTimeSec: "
+              << static_cast<double>(timer.GetNanoSec()) / kNumIterations
+              << " ns/read" << (sum ? "" : " ") << std::endl;
+  }
+  MeasureClock<LOG::MonotonicClock>("MonotonicClock");
+  MeasureClock<LOG::TscClock>("TscClock");
+  return 0;
+}
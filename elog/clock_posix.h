@@ -0,0 +1,56 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_CLOCK_POSIX_H_
+#define ELOG_CLOCK_POSIX_H_
+
+#include <ctime>
+#include <time.h>
+
+namespace LOG {
+
+// Clock which never goes back, in nanoseconds from an unspecified origin.
+struct MonotonicClock {
+  typedef long long Tick;
+
+  static Tick Now() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+  }
+
+  static long long ToNanoSec(Tick ticks) {
+    return ticks;
+  }
+};
+
+// Time since the epoch.
+struct WallClockTime {
+  long long sec;
+  int micro_sec;
+};
+
+// The coarse clock is cheaper to read, but it only advances every few
+// milliseconds.
+inline WallClockTime GetWallClockTime(bool is_coarse) {
+  timespec now;
+#ifdef CLOCK_REALTIME_COARSE
+  clock_gettime(is_coarse ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &now);
+#else
+  (void)is_coarse;
+  clock_gettime(CLOCK_REALTIME, &now);
+#endif
+  const WallClockTime time = {
+    now.tv_sec, static_cast<int>(now.tv_nsec / 1000)
+  };
+  return time;
+}
+
+inline void GetLocalTime(long long sec, std::tm& tm) {
+  const time_t time = static_cast<time_t>(sec);
+  localtime_r(&time, &tm);
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_CLOCK_POSIX_H_
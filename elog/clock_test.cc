@@ -0,0 +1,60 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <gtest/gtest.h>
+#include "clock.h"
+#include "thread.h"
+#include "timer.h"
+
+namespace LOG {
+
+namespace {
+
+const int kSleepMilliSec = 50;
+
+template <typename ClockType>
+void VerifyClockMeasuresSleep() {
+  const typename ClockType::Tick start = ClockType::Now();
+  SleepMilliSec(kSleepMilliSec);
+  const long long elapsed = ClockType::ToNanoSec(ClockType::Now() - start);
+  EXPECT_LE(kSleepMilliSec * 900000LL, elapsed);
+  EXPECT_GT(kSleepMilliSec * 10000000LL, elapsed);
+}
+
+}  // anonymous namespace
+
+TEST(ClockTest, MonotonicClockNeverGoesBack) {
+  MonotonicClock::Tick last = MonotonicClock::Now();
+  for (int i = 0; i < 100000; ++i) {
+    const MonotonicClock::Tick now = MonotonicClock::Now();
+    ASSERT_LE(last, now);
+    last = now;
+  }
+}
+
+TEST(ClockTest, MonotonicClockMeasuresSleep) {
+  VerifyClockMeasuresSleep<MonotonicClock>();
+}
+
+TEST(ClockTest, TscClockMeasuresSleep) {
+  VerifyClockMeasuresSleep<TscClock>();
+}
+
+TEST(TimerTest, NanoSecAndSec) {
+  Timer timer;
+  SleepMilliSec(kSleepMilliSec);
+  const long long nano_sec = timer.GetNanoSec();
+  const double sec = timer.GetTime();
+  EXPECT_LE(kSleepMilliSec * 900000LL, nano_sec);
+  EXPECT_LE(nano_sec * 1e-9, sec);
+  EXPECT_GT(kSleepMilliSec * 10e-3, sec);
+}
+
+TEST(TimerTest, Restart) {
+  BasicTimer<MonotonicClock> timer;
+  SleepMilliSec(kSleepMilliSec);
+  timer.Restart();
+  EXPECT_GT(kSleepMilliSec * 900000LL, timer.GetNanoSec());
+}
+
+}  // namespace LOG
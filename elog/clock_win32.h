@@ -0,0 +1,59 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_CLOCK_WIN32_H_
+#define ELOG_CLOCK_WIN32_H_
+
+#include <ctime>
+#include <windows.h>
+
+namespace LOG {
+
+// Clock which never goes back, in ticks of the performance counter.
+struct MonotonicClock {
+  typedef long long Tick;
+
+  static Tick Now() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+  }
+
+  static long long ToNanoSec(Tick ticks) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return ticks / frequency.QuadPart * 1000000000LL +
+        ticks % frequency.QuadPart * 1000000000LL / frequency.QuadPart;
+  }
+};
+
+// Time since the epoch.
+struct WallClockTime {
+  long long sec;
+  int micro_sec;
+};
+
+// The system time is only updated at each timer interrupt, so the coarse and
+// the precise clock are the same.
+inline WallClockTime GetWallClockTime(bool) {
+  static const long long kEpochIn100NanoSec = 116444736000000000LL;
+
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  const long long ticks =
+      (static_cast<long long>(now.dwHighDateTime) << 32 | now.dwLowDateTime) -
+      kEpochIn100NanoSec;
+  const WallClockTime time = {
+    ticks / 10000000, static_cast<int>(ticks % 10000000 / 10)
+  };
+  return time;
+}
+
+inline void GetLocalTime(long long sec, std::tm& tm) {
+  const __time64_t time = sec;
+  _localtime64_s(&tm, &time);
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_CLOCK_WIN32_H_
@@ -8,4 +8,41 @@
 # define ELOG_I_USE_TR1_HEADER
 #endif
 
+// Storage class of thread-local variables. Only PODs can be thread-local.
+#ifdef _MSC_VER
+# define ELOG_I_THREAD_LOCAL __declspec(thread)
+#else
+# define ELOG_I_THREAD_LOCAL __thread
+#endif
+
+// Compile-time filters of log statements. Filtered statements compile to
+// nothing, as DLOG() does under NDEBUG, and their arguments are not evaluated.
+//
+// ELOG_MIN_LEVEL: LOG(level) less severe than this level is removed. Define it
+// to one of INFO, WARN and ERROR. FATAL and CHECK are never removed.
+// ELOG_MAX_VERBOSITY: LOG(type, verbosity) with verbosity greater than this
+// value is removed.
+#ifndef ELOG_MIN_LEVEL
+# define ELOG_MIN_LEVEL INFO
+#endif
+
+// LOG(type, verbosity) names the type by typeid() and demangles the name once
+// per type. With ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION, which is defined by
+// default when RTTI is disabled, the name is cut out of __PRETTY_FUNCTION__
+// (__FUNCSIG__ of MSVC) instead; the names may be spelled differently.
+#if !defined(ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION) && \
+    ((defined(__GNUC__) && !defined(__GXX_RTTI)) || \
+     (defined(_MSC_VER) && !defined(_CPPRTTI)))
+# define ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+#endif
+
+#ifdef _MSC_VER
+# define ELOG_I_PRETTY_FUNCTION __FUNCSIG__
+#else
+# define ELOG_I_PRETTY_FUNCTION __PRETTY_FUNCTION__
+#endif
+
+// Define ELOG_USE_TSC_CLOCK to make Timer and benchmarks read the time stamp
+// counter of x86 CPUs instead of the monotonic clock of the OS. See clock.h.
+
 #endif  // ELOG_CONFIG_H_
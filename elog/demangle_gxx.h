@@ -10,6 +10,7 @@
 #else
 # include <memory>
 #endif
+#include <cstdlib>
 #include <cxxabi.h>
 
 namespace LOG {
@@ -19,7 +20,7 @@ class Demangle {
   explicit Demangle(const char* mangled_name) {
     int status;
     char* demangled_name = abi::__cxa_demangle(mangled_name, 0, 0, &status);
-    type_name_.reset(demangled_name);
+    type_name_.reset(demangled_name, std::free);
   }
 
   const char* GetName() const {
@@ -11,7 +11,7 @@ namespace LOG {
 
 struct NullStream {
   template <typename T>
-  NullStream& operator<<(T) const {
+  const NullStream& operator<<(T) const {
     return *this;
   }
 };
@@ -76,12 +76,29 @@ struct VoidEmitter {
 
 #define ELOG_I_LOG_0() ELOG_I_LOG_1(INFO)
 
-// '<' and '::' must be separated by white space, because <:: is a trigram
+// '<' and '::' must be separated by white space, because <:: is a trigram.
+// When the level is disabled, the GeneralLog is not even constructed and the
+// arguments are not evaluated.
 #define ELOG_I_LOG_1(level) \
+  !(::LOG::GeneralLog< ::LOG::level>::kIsCompiledIn && \
+    ::LOG::IsLogLevelEnabled< ::LOG::level>()) ? (void)0 : \
   ::LOG::LogEmitTrigger() & \
   ::LOG::GeneralLog< ::LOG::level>(ELOG_I_FILE, ELOG_I_LINE).GetReference()
 
+#ifdef ELOG_MAX_VERBOSITY
+# define ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) \
+  ((verbosity) <= (ELOG_MAX_VERBOSITY))
+#else
+# define ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) true
+#endif
+
+// The verbosity expression is evaluated more than once.
 #define ELOG_I_LOG_2(type, verbosity) \
+  !(ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) && \
+    ::LOG::IsTypedLogEnabled( \
+        ::LOG::TypedLogSiteHolder<type, ::LOG::TranslationUnitTag, \
+                                  ELOG_I_LINE>::site, \
+        (verbosity), ELOG_I_FILE, ELOG_I_LINE)) ? (void)0 : \
   ::LOG::LogEmitTrigger() & \
   ::LOG::TypedLog(::LOG::TypeInfo(::LOG::Type<type>()), (verbosity), \
                   ELOG_I_FILE, ELOG_I_LINE).GetReference()
@@ -0,0 +1,69 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the cost of LOG statements whose level or verbosity is disabled.
+
+#include <iostream>
+#include "elog.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 10000000;
+
+class SomeModule {};
+
+void PrintNanoSecPerStatement(const char* title, double time) {
+  std::cout << title << ": " << time * 1e9 / kNumIterations
+            << " ns/statement" << std::endl;
+}
+
+// LOG(INFO) without the level check before the construction of GeneralLog.
+void RunDisabledGeneralLog() {
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    ::LOG::LogEmitTrigger() &
+        ::LOG::GeneralLog< ::LOG::INFO>(ELOG_I_FILE, ELOG_I_LINE)
+        .GetReference() << "value: " << i;
+  }
+  PrintNanoSecPerStatement("disabled GeneralLog", timer.GetTime());
+}
+
+void RunDisabledLOG() {
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    LOG(INFO) << "value: " << i;
+  }
+  PrintNanoSecPerStatement("disabled LOG(INFO)", timer.GetTime());
+}
+
+// LOG(SomeModule, 1) without the verbosity cached in the log site.
+void RunDisabledTypedLog() {
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    ::LOG::LogEmitTrigger() &
+        ::LOG::TypedLog(::LOG::TypeInfo(::LOG::Type<SomeModule>()), 1,
+                        ELOG_I_FILE, ELOG_I_LINE)
+        .GetReference() << "value: " << i;
+  }
+  PrintNanoSecPerStatement("disabled TypedLog", timer.GetTime());
+}
+
+void RunDisabledTypedLOG() {
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    LOG(SomeModule, 1) << "value: " << i;
+  }
+  PrintNanoSecPerStatement("disabled LOG(SomeModule, 1)", timer.GetTime());
+}
+
+}  // anonymous namespace
+
+int main() {
+  LOG::SetDefaultLoggerLevel(LOG::WARN);
+  RunDisabledGeneralLog();
+  RunDisabledLOG();
+  RunDisabledTypedLog();
+  RunDisabledTypedLOG();
+  return 0;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Compares two benchmark results written by WriteBenchmarkJson() or
+// WriteBenchmarkCsv(), and fails if the median of any case regressed.
+//
+// Usage: elog_compare [-t threshold] baseline current
+//   -t    relative growth of the median regarded as a regression
+//         (default: 0.05)
+// Exits with 1 if any case regressed, and 2 on errors.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "benchmark_export.h"
+
+namespace {
+
+bool ReadReport(const char* file_name, LOG::BenchmarkReport& report) {
+  std::ifstream file(file_name);
+  if (!file) {
+    std::cerr << "cannot open " << file_name << std::endl;
+    return false;
+  }
+  try {
+    report = LOG::ReadBenchmarkReport(file);
+  } catch (const LOG::BenchmarkExportFormatError&) {
+    std::cerr << "broken benchmark result: " << file_name << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  double threshold = 0.05;
+  std::vector<const char*> file_names;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threshold = std::atof(argv[++i]);
+    } else {
+      file_names.push_back(argv[i]);
+    }
+  }
+  if (file_names.size() != 2) {
+    std::cerr << "usage: " << argv[0] << " [-t threshold] baseline current"
+              << std::endl;
+    return 2;
+  }
+
+  LOG::BenchmarkReport baseline, current;
+  if (!ReadReport(file_names[0], baseline) ||
+      !ReadReport(file_names[1], current)) {
+    return 2;
+  }
+
+  const std::vector<LOG::BenchmarkComparison> comparisons =
+      LOG::CompareBenchmarkReports(baseline, current, threshold);
+  bool is_regressed = false;
+  for (std::size_t i = 0; i < comparisons.size(); ++i) {
+    const LOG::BenchmarkComparison& comparison = comparisons[i];
+    char line[64];
+    std::snprintf(line, sizeof(line), "%14.6g %14.6g %+8.2f%% ",
+                  comparison.baseline_median, comparison.current_median,
+                  comparison.change * 100);
+    std::cout << line << (comparison.is_regressed ? "REGRESSED " : "")
+              << comparison.name << std::endl;
+    is_regressed = is_regressed || comparison.is_regressed;
+  }
+  return is_regressed ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Renders binary logs written by BinaryLogger as text.
+//
+// Usage: elog_decode [-t] [file]
+//   -t    prefix each message by the time it was written
+// Reads the standard input if no file is given.
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "binary_log_decoder.h"
+
+int main(int argc, char** argv) {
+  bool prints_timestamp = false;
+  const char* file_name = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-t") == 0) {
+      prints_timestamp = true;
+    } else if (!file_name) {
+      file_name = argv[i];
+    } else {
+      std::cerr << "usage: " << argv[0] << " [-t] [file]" << std::endl;
+      return 2;
+    }
+  }
+
+  std::ifstream file;
+  if (file_name) {
+    file.open(file_name, std::ios::in | std::ios::binary);
+    if (!file) {
+      std::cerr << argv[0] << ": cannot open " << file_name << std::endl;
+      return 1;
+    }
+  }
+
+  LOG::BinaryLogDecoder decoder(file_name ? file : std::cin);
+  decoder.set_prints_timestamp(prints_timestamp);
+  try {
+    decoder.Decode(std::cout);
+  } catch (const LOG::BinaryLogFormatError&) {
+    std::cerr << argv[0] << ": broken binary log" << std::endl;
+    return 1;
+  }
+  return 0;
+}
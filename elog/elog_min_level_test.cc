@@ -0,0 +1,75 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#define ELOG_MIN_LEVEL WARN
+#define ELOG_MAX_VERBOSITY 1
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "elog.h"
+
+namespace LOG {
+
+namespace {
+
+class SomeModule {};
+
+}  // anonymous namespace
+
+class LOGMinLevelTest : public ::testing::Test {
+ public:
+  LOGMinLevelTest()
+      : logger_(stream_) {
+  }
+
+ protected:
+  virtual void SetUp() {
+    SetLogger(logger_);
+    logger_.SetTypeVerbosity(TypeInfo(Type<SomeModule>()), 2);
+  }
+
+  virtual void TearDown() {
+    UseDefaultLogger();
+  }
+
+  std::string GetMessage() const {
+    return stream_.str();
+  }
+
+ private:
+  std::ostringstream stream_;
+  StreamLogger logger_;
+};
+
+TEST_F(LOGMinLevelTest, LevelRemoved) {
+  int evaluation_count = 0;
+  LOG(INFO) << ++evaluation_count;
+  LOG() << ++evaluation_count;
+  EXPECT_EQ(0, evaluation_count);
+  EXPECT_EQ("", GetMessage());
+}
+
+TEST_F(LOGMinLevelTest, LevelCompiledIn) {
+  LOG(WARN) << "message";
+  EXPECT_NE(std::string::npos, GetMessage().find("[WARN]"));
+}
+
+TEST_F(LOGMinLevelTest, FatalAndCheckCompiledIn) {
+  EXPECT_THROW(LOG(FATAL), FatalLogError);
+  EXPECT_THROW(CHECK(false), CheckError);
+}
+
+TEST_F(LOGMinLevelTest, VerbosityRemoved) {
+  int evaluation_count = 0;
+  LOG(SomeModule, 2) << ++evaluation_count;
+  EXPECT_EQ(0, evaluation_count);
+  EXPECT_EQ("", GetMessage());
+}
+
+TEST_F(LOGMinLevelTest, VerbosityCompiledIn) {
+  LOG(SomeModule, 1) << "message";
+  EXPECT_NE(std::string::npos, GetMessage().find("message"));
+}
+
+}  // namespace LOG
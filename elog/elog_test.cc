@@ -1,11 +1,20 @@
 // Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
 // This source code is distributed under MIT License in LICENSE file.
 
+#include "config.h"
+
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
 #include <gtest/gtest.h>
 #include "elog.h"
+#include "thread.h"
 
 namespace LOG {
 
@@ -16,6 +25,22 @@ const char* kMessage = "message";
 class SomeModule {};
 class AnotherModule {};
 
+int LogSomeModule(int verbosity) {
+  int evaluation_count = 0;
+  LOG(SomeModule, verbosity) << kMessage << ++evaluation_count;
+  return evaluation_count;
+}
+
+TypeInfo GetSomeModuleTypeInfo() {
+  return TypeInfo(Type<SomeModule>());
+}
+
+void CheckSite(TypedLogSite* site, volatile bool* is_stopped) {
+  while (!*is_stopped) {
+    IsTypedLogEnabled(*site, 1, __FILE__, __LINE__);
+  }
+}
+
 }  // anonymous namespace
 
 class LOGTest : public ::testing::Test {
@@ -68,7 +93,7 @@ class LOGTest : public ::testing::Test {
   template <typename T>
   void VerifyType() const {
     const TypeInfo type_info((Type<T>()));
-    const std::string type_name(type_info.GetTypeName().GetName());
+    const std::string type_name(type_info.GetName());
     VerifyMessage(type_name);
   }
 
@@ -148,6 +173,13 @@ TEST_F(LOGTest, LevelNotHighEnough) {
   VerifyEmpty();
 }
 
+TEST_F(LOGTest, LevelNotHighEnoughSkipsArguments) {
+  SetLevel(WARN);
+  int evaluation_count = 0;
+  LOG(INFO) << ++evaluation_count;
+  EXPECT_EQ(0, evaluation_count);
+}
+
 TEST_F(LOGTest, LevelHighEnough) {
   SetLevel(ERROR);
   LOG(ERROR);
@@ -183,6 +215,78 @@ TEST_F(LOGTest, MessageOfAnotherType) {
   VerifyEmpty();
 }
 
+TEST_F(LOGTest, VerbosityNotLowEnoughSkipsArguments) {
+  EXPECT_EQ(0, LogSomeModule(1));
+  VerifyEmpty();
+}
+
+TEST_F(LOGTest, SiteFollowsVerbosityChange) {
+  LogSomeModule(1);
+  VerifyEmpty();
+
+  SetVerbosity<SomeModule>(1);
+  EXPECT_EQ(1, LogSomeModule(1));
+  VerifyType<SomeModule>();
+
+  Reset();
+  SetVerbosity<SomeModule>(0);
+  LogSomeModule(1);
+  VerifyEmpty();
+}
+
+TEST_F(LOGTest, SiteBeingRefreshedIsNotOverwritten) {
+  // Registered beforehand, so that the list of sites does not hold it.
+  TypedLogSite site = {
+    &GetSomeModuleTypeInfo, kRefreshingLogSite, 5, 1, 0, NULL, 0, 0, NULL
+  };
+  SetVerbosity<SomeModule>(1);
+  EXPECT_TRUE(IsTypedLogEnabled(site, 1, __FILE__, __LINE__));
+  EXPECT_EQ(kRefreshingLogSite, site.generation);
+  EXPECT_EQ(5, site.type_verbosity);
+
+  site.generation = 0;
+  EXPECT_TRUE(IsTypedLogEnabled(site, 1, __FILE__, __LINE__));
+  EXPECT_EQ(GetLogGeneration(), site.generation);
+  EXPECT_EQ(1, site.type_verbosity);
+}
+
+TEST_F(LOGTest, SiteFollowsConcurrentVerbosityChanges) {
+  static const int kNumThreads = 4;
+  TypedLogSite site = {
+    &GetSomeModuleTypeInfo, 0, 0, 1, 0, NULL, 0, 0, NULL
+  };
+  volatile bool is_stopped = false;
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(std::tr1::bind(CheckSite, &site,
+                                                &is_stopped)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < 10000; ++i) {
+    SetVerbosity<SomeModule>(i % 2);
+  }
+  SetVerbosity<SomeModule>(1);
+  is_stopped = true;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  EXPECT_TRUE(IsTypedLogEnabled(site, 1, __FILE__, __LINE__));
+  EXPECT_EQ(1, site.type_verbosity);
+}
+
+TEST_F(LOGTest, SiteIsRegistered) {
+  LogSomeModule(0);
+  bool found = false;
+  for (const TypedLogSite* site = GetTypedLogSites(); site; site = site->next) {
+    if (site->get_type_info() == TypeInfo(Type<SomeModule>())) {
+      EXPECT_STREQ(ELOG_I_FILE, site->source_file_name);
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
 
 TEST_F(LOGTest, PrintSignedChar) {
   const signed char value = 65;
@@ -4,10 +4,12 @@
 #ifndef ELOG_GENERAL_LOG_H_
 #define ELOG_GENERAL_LOG_H_
 
-#include <sstream>
+#include "config.h"
+
 #include <string>
 #include "logger.h"
 #include "logger_factory.h"
+#include "message_stream.h"
 #include "put_as_string.h"
 
 namespace LOG {
@@ -15,6 +17,9 @@ namespace LOG {
 template <LogLevel LEVEL>
 class GeneralLog {
  public:
+  // False if LOG(LEVEL) is removed by ELOG_MIN_LEVEL.
+  static const bool kIsCompiledIn = LEVEL >= FATAL || LEVEL >= ELOG_MIN_LEVEL;
+
   GeneralLog(const char* source_file_name,
              int line_number,
              Logger* logger = NULL)
@@ -40,12 +45,13 @@ class GeneralLog {
   }
 
   void PushMessage() const {
-    logger_.PushMessage(LEVEL, source_file_name_, line_number_, stream_.str());
+    logger_.PushMessage(LEVEL, source_file_name_, line_number_,
+                        stream_.data(), stream_.size());
   }
 
  private:
   Logger& logger_;
-  std::ostringstream stream_;
+  MessageStream stream_;
   const char* source_file_name_;
   int line_number_;
 };
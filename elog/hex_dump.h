@@ -0,0 +1,244 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_HEX_DUMP_H_
+#define ELOG_HEX_DUMP_H_
+
+#if defined(__AVX2__)
+# define ELOG_I_HEX_DUMP_AVX2
+# include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define ELOG_I_HEX_DUMP_SSE2
+# include <emmintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include "number_format.h"
+#include "put_as_string.h"
+
+namespace LOG {
+
+// Wrapper of a byte buffer written in the canonical hex+ASCII format, as
+// "hexdump -C" prints, one line of 16 bytes after each newline:
+//
+//   LOG() << "received" << LOG::HexDump(packet, size);
+//
+// Each line has the offset, the bytes in hex and the printable characters
+// between '|'s. The max_bytes limit of LimitPrinting() applies to the bytes of
+// the buffer; the rest is omitted as "...(N more bytes)". The buffer must live
+// until the statement ends.
+class HexDump {
+ public:
+  HexDump(const void* data, std::size_t size)
+      : data_(static_cast<const unsigned char*>(data)),
+        size_(size) {
+  }
+
+  const unsigned char* data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+ private:
+  const unsigned char* data_;
+  std::size_t size_;
+};
+
+static const std::size_t kHexDumpLineSize = 16;  // bytes
+
+// Encodes the lines of bytes into 32 lowercase hex digits and 16 printable
+// characters per line, with '.' for the others.
+inline void EncodeHexLinesScalar(const unsigned char* bytes,
+                                 std::size_t num_lines,
+                                 char* hex,
+                                 char* ascii) {
+  static const char kDigits[] = "0123456789abcdef";
+  for (std::size_t i = 0; i < num_lines * kHexDumpLineSize; ++i) {
+    const unsigned char byte = bytes[i];
+    hex[i * 2] = kDigits[byte >> 4];
+    hex[i * 2 + 1] = kDigits[byte & 15];
+    ascii[i] = byte >= 0x20 && byte < 0x7f ? static_cast<char>(byte) : '.';
+  }
+}
+
+#if defined(ELOG_I_HEX_DUMP_SSE2) || defined(ELOG_I_HEX_DUMP_AVX2)
+
+// The SIMD kernels compute digits as nibble + '0', plus 'a' - '0' - 10 for the
+// nibbles over 9, and printable characters by signed comparisons, which
+// treat the bytes of 0x80 and over as negative.
+# define ELOG_I_DEFINE_HEX_KERNEL(Vector, prefix, suffix)                    \
+  inline void EncodeHex##suffix(Vector bytes, Vector& low, Vector& high,   \
+                                Vector& ascii) {                           \
+    const Vector nibble_mask = prefix##_set1_epi8(0x0f);                   \
+    const Vector hi = prefix##_and_si##suffix(                             \
+        prefix##_srli_epi16(bytes, 4), nibble_mask);                       \
+    const Vector lo = prefix##_and_si##suffix(bytes, nibble_mask);         \
+    const Vector zero = prefix##_set1_epi8('0');                           \
+    const Vector nine = prefix##_set1_epi8(9);                             \
+    const Vector letter = prefix##_set1_epi8('a' - '0' - 10);              \
+    const Vector hi_digits = prefix##_add_epi8(                            \
+        prefix##_add_epi8(hi, zero),                                       \
+        prefix##_and_si##suffix(prefix##_cmpgt_epi8(hi, nine), letter));   \
+    const Vector lo_digits = prefix##_add_epi8(                            \
+        prefix##_add_epi8(lo, zero),                                       \
+        prefix##_and_si##suffix(prefix##_cmpgt_epi8(lo, nine), letter));   \
+    low = prefix##_unpacklo_epi8(hi_digits, lo_digits);                    \
+    high = prefix##_unpackhi_epi8(hi_digits, lo_digits);                   \
+    const Vector printable = prefix##_and_si##suffix(                      \
+        prefix##_cmpgt_epi8(bytes, prefix##_set1_epi8(0x1f)),              \
+        prefix##_cmpgt_epi8(prefix##_set1_epi8(0x7f), bytes));             \
+    ascii = prefix##_or_si##suffix(                                        \
+        prefix##_and_si##suffix(printable, bytes),                         \
+        prefix##_andnot_si##suffix(printable, prefix##_set1_epi8('.')));   \
+  }
+
+ELOG_I_DEFINE_HEX_KERNEL(__m128i, _mm, 128)
+# ifdef ELOG_I_HEX_DUMP_AVX2
+ELOG_I_DEFINE_HEX_KERNEL(__m256i, _mm256, 256)
+# endif
+
+# undef ELOG_I_DEFINE_HEX_KERNEL
+
+#endif
+
+// Same as EncodeHexLinesScalar(), by SSE2 or AVX2 where available.
+inline void EncodeHexLines(const unsigned char* bytes,
+                           std::size_t num_lines,
+                           char* hex,
+                           char* ascii) {
+  std::size_t i = 0;
+#ifdef ELOG_I_HEX_DUMP_AVX2
+  // The 128-bit lanes of AVX2 unpack separately, so that each lane holds
+  // the digits of a line.
+  for (; i + 2 <= num_lines; i += 2) {
+    __m256i low, high, printable;
+    EncodeHex256(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(bytes + i * kHexDumpLineSize)),
+                 low, high, printable);
+    char* const line_hex = hex + i * kHexDumpLineSize * 2;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(line_hex),
+                        _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(line_hex + 32),
+                        _mm256_permute2x128_si256(low, high, 0x31));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(ascii + i * kHexDumpLineSize), printable);
+  }
+#endif
+#if defined(ELOG_I_HEX_DUMP_SSE2) || defined(ELOG_I_HEX_DUMP_AVX2)
+  for (; i < num_lines; ++i) {
+    __m128i low, high, printable;
+    EncodeHex128(_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(bytes + i * kHexDumpLineSize)),
+                 low, high, printable);
+    char* const line_hex = hex + i * kHexDumpLineSize * 2;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(line_hex), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(line_hex + 16), high);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(ascii + i * kHexDumpLineSize), printable);
+  }
+#endif
+  EncodeHexLinesScalar(bytes + i * kHexDumpLineSize, num_lines - i,
+                       hex + i * kHexDumpLineSize * 2,
+                       ascii + i * kHexDumpLineSize);
+}
+
+// Lays out a line of the dump from the encoded digits and characters of the
+// given number of bytes, and returns its size.
+inline std::size_t FormatHexDumpLine(unsigned long long offset,
+                                     const char* hex,
+                                     const char* ascii,
+                                     std::size_t num_bytes,
+                                     char* line) {
+  char* p = line;
+  *p++ = '\n';
+  char offset_digits[kMaxUnsignedDigits];
+  std::size_t num_offset_digits = 0;
+  for (unsigned long long n = offset; n != 0 || num_offset_digits < 8;
+       n >>= 4) {
+    offset_digits[num_offset_digits++] = "0123456789abcdef"[n & 15];
+  }
+  while (num_offset_digits > 0) {
+    *p++ = offset_digits[--num_offset_digits];
+  }
+  *p++ = ' ';
+  for (std::size_t i = 0; i < kHexDumpLineSize; ++i) {
+    *p++ = ' ';
+    if (i == kHexDumpLineSize / 2) {
+      *p++ = ' ';
+    }
+    if (i < num_bytes) {
+      p[0] = hex[i * 2];
+      p[1] = hex[i * 2 + 1];
+    } else {
+      p[0] = p[1] = ' ';
+    }
+    p += 2;
+  }
+  *p++ = ' ';
+  *p++ = ' ';
+  *p++ = '|';
+  std::memcpy(p, ascii, num_bytes);
+  p += num_bytes;
+  *p++ = '|';
+  return p - line;
+}
+
+template <>
+struct StringBuildFunction<HexDump, false> {
+  template <typename Stream>
+  void operator()(const HexDump& dump, Stream& stream) const {
+    std::size_t size = dump.size();
+    const PrintState* state = GetPrintState(stream);
+    if (state && state->limits.max_bytes != 0 &&
+        size > state->limits.max_bytes) {
+      size = state->limits.max_bytes;
+    }
+
+    // Lines are encoded and written in blocks.
+    static const std::size_t kBlockLines = 64;
+    static const std::size_t kMaxLineSize = 96;
+    char hex[kBlockLines * kHexDumpLineSize * 2];
+    char ascii[kBlockLines * kHexDumpLineSize];
+    char text[kBlockLines * kMaxLineSize];
+    const unsigned char* const data = dump.data();
+    for (std::size_t begin = 0; begin < size;
+         begin += kBlockLines * kHexDumpLineSize) {
+      const std::size_t num_bytes =
+          size - begin < kBlockLines * kHexDumpLineSize ?
+          size - begin : kBlockLines * kHexDumpLineSize;
+      const std::size_t num_full_lines = num_bytes / kHexDumpLineSize;
+      EncodeHexLines(data + begin, num_full_lines, hex, ascii);
+      const std::size_t rest = num_bytes % kHexDumpLineSize;
+      if (rest != 0) {
+        unsigned char last_line[kHexDumpLineSize] = {};
+        std::memcpy(last_line, data + begin + num_full_lines * kHexDumpLineSize,
+                    rest);
+        EncodeHexLinesScalar(last_line, 1,
+                             hex + num_full_lines * kHexDumpLineSize * 2,
+                             ascii + num_full_lines * kHexDumpLineSize);
+      }
+
+      std::size_t text_size = 0;
+      for (std::size_t i = 0; i * kHexDumpLineSize < num_bytes; ++i) {
+        const std::size_t line_bytes =
+            i < num_full_lines ? kHexDumpLineSize : rest;
+        text_size += FormatHexDumpLine(
+            begin + i * kHexDumpLineSize, hex + i * kHexDumpLineSize * 2,
+            ascii + i * kHexDumpLineSize, line_bytes, text + text_size);
+      }
+      stream.write(text, text_size);
+    }
+    if (size < dump.size()) {
+      stream << "\n...(" << dump.size() - size << " more bytes)";
+    }
+  }
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_HEX_DUMP_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the throughput of dumping a buffer of some megabytes in hex, by
+// std::ostringstream, by the scalar and the SIMD encoders of HexDump, and by
+// HexDump written into a MessageStream.
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "hex_dump.h"
+#include "message_stream.h"
+#include "timer.h"
+
+namespace {
+
+const std::size_t kBufferSize = 4 << 20;
+const int kNumIterations = 10;
+
+void PrintThroughput(const char* title, double time) {
+  const double bytes = static_cast<double>(kBufferSize) * kNumIterations;
+  std::cout << title << ": " << bytes / time / (1 << 20) << " MB/sec"
+            << std::endl;
+}
+
+template <void (*Encode)(const unsigned char*, std::size_t, char*, char*)>
+std::size_t MeasureEncoder(const char* title,
+                           const std::vector<unsigned char>& bytes) {
+  const std::size_t num_lines = bytes.size() / LOG::kHexDumpLineSize;
+  std::vector<char> hex(bytes.size() * 2), ascii(bytes.size());
+  std::size_t checksum = 0;
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    Encode(&bytes[0], num_lines, &hex[0], &ascii[0]);
+    checksum += hex[i] + ascii[i];
+  }
+  PrintThroughput(title, timer.GetTime());
+  return checksum;
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::vector<unsigned char> bytes(kBufferSize);
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<unsigned char>(i * 2654435761U >> 13);
+  }
+
+  std::size_t total_size = 0;
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      std::ostringstream stream;
+      stream << std::hex << std::setfill('0');
+      for (std::size_t j = 0; j < bytes.size(); ++j) {
+        stream << std::setw(2) << static_cast<unsigned int>(bytes[j]) << ' ';
+      }
+      total_size += stream.str().size();
+    }
+    PrintThroughput("std::ostringstream (hex only)", timer.GetTime());
+  }
+  total_size += MeasureEncoder<LOG::EncodeHexLinesScalar>(
+      "scalar encoder", bytes);
+  total_size += MeasureEncoder<LOG::EncodeHexLines>(
+#if defined(ELOG_I_HEX_DUMP_AVX2)
+      "AVX2 encoder",
+#elif defined(ELOG_I_HEX_DUMP_SSE2)
+      "SSE2 encoder",
+#else
+      "encoder",
+#endif
+      bytes);
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG::MessageStream stream;
+      LOG::PutAsString(LOG::HexDump(&bytes[0], bytes.size()), stream);
+      total_size += stream.size();
+    }
+    PrintThroughput("HexDump to MessageStream", timer.GetTime());
+  }
+  return total_size == 0;
+}
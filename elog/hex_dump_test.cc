@@ -0,0 +1,82 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "hex_dump.h"
+#include "message_stream.h"
+
+namespace LOG {
+
+namespace {
+
+std::string GetDump(const void* data, std::size_t size) {
+  std::ostringstream stream;
+  PutAsString(HexDump(data, size), stream);
+  return stream.str();
+}
+
+}  // anonymous namespace
+
+TEST(HexDumpTest, Canonical) {
+  const char kData[] = "0123456789abcdef\x80\x7f\x1f ~";
+  EXPECT_EQ(
+      "\n00000000  30 31 32 33 34 35 36 37  38 39 61 62 63 64 65 66"
+      "  |0123456789abcdef|"
+      "\n00000010  80 7f 1f 20 7e                                  "
+      "  |... ~|",
+      GetDump(kData, sizeof(kData) - 1));
+}
+
+TEST(HexDumpTest, Empty) {
+  EXPECT_EQ("", GetDump("", 0));
+}
+
+TEST(HexDumpTest, SameAsScalar) {
+  std::vector<unsigned char> bytes(16 * 37);
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<unsigned char>(i * 2654435761U >> 13);
+  }
+  const std::size_t num_lines = bytes.size() / kHexDumpLineSize;
+  std::vector<char> hex(num_lines * 32), ascii(num_lines * 16);
+  std::vector<char> scalar_hex(hex.size()), scalar_ascii(ascii.size());
+  for (std::size_t n = 0; n <= num_lines; ++n) {
+    EncodeHexLines(&bytes[0], n, &hex[0], &ascii[0]);
+    EncodeHexLinesScalar(&bytes[0], n, &scalar_hex[0], &scalar_ascii[0]);
+    ASSERT_EQ(0, std::memcmp(&hex[0], &scalar_hex[0], n * 32));
+    ASSERT_EQ(0, std::memcmp(&ascii[0], &scalar_ascii[0], n * 16));
+  }
+}
+
+TEST(HexDumpTest, LongBuffer) {
+  std::vector<unsigned char> bytes(16 * 100 + 5, 'x');
+  const std::string dump = GetDump(&bytes[0], bytes.size());
+  EXPECT_EQ(100 * 79 + 68, static_cast<int>(dump.size()));
+  EXPECT_NE(std::string::npos, dump.find("\n00000640  78 78 78 78 78  "));
+}
+
+TEST(HexDumpTest, LongOffset) {
+  char line[96];
+  const char hex[] = "00";
+  const std::size_t size =
+      FormatHexDumpLine(0x123456789ULL, hex, ".", 1, line);
+  EXPECT_EQ("\n123456789  00", std::string(line, 14));
+  EXPECT_EQ("|.|", std::string(line + size - 3, 3));
+}
+
+TEST(HexDumpTest, MaxBytes) {
+  std::vector<unsigned char> bytes(100);
+  MessageStream stream;
+  PutAsString(LimitPrinting(0, 0, 20), stream);
+  PutAsString(HexDump(&bytes[0], bytes.size()), stream);
+  const std::string dump = stream.str();
+  EXPECT_NE(std::string::npos, dump.find("\n00000010  00 00 00 00  "));
+  EXPECT_EQ(std::string::npos, dump.find("\n00000020"));
+  EXPECT_EQ("\n...(80 more bytes)", dump.substr(dump.size() - 19));
+}
+
+}  // namespace LOG
@@ -0,0 +1,172 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_LATENCY_HISTOGRAM_H_
+#define ELOG_LATENCY_HISTOGRAM_H_
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace LOG {
+
+// Log-linear histogram of non-negative integer values such as latencies in
+// picoseconds, in the manner of HdrHistogram. Values below 2^kSubBucketBits
+// are counted exactly; larger ones fall in one of 2^(kSubBucketBits - 1)
+// buckets per power of two, so each bucket is narrower than 1/64 of its
+// values. Recording is O(1) and the memory is fixed. Values above kMaxValue
+// are counted as kMaxValue.
+//
+// The count, min, max, mean and standard deviation are exact. Quantiles are
+// the midpoints of buckets, clamped to the min and the max.
+class LatencyHistogram {
+ public:
+  static const int kSubBucketBits = 7;
+  static const int kMaxValueBits = 55;  // about 10 hours in picoseconds
+  static const long long kMaxValue = (1LL << kMaxValueBits) - 1;
+  static const std::size_t kNumBuckets =
+      (1 << kSubBucketBits) +
+      (kMaxValueBits - kSubBucketBits) * (1 << (kSubBucketBits - 1));
+
+  LatencyHistogram()
+      : counts_(kNumBuckets) {
+    Clear();
+  }
+
+  long long count() const {
+    return count_;
+  }
+
+  long long min() const {
+    return count_ ? min_ : 0;
+  }
+
+  long long max() const {
+    return max_;
+  }
+
+  long long bucket_count(std::size_t index) const {
+    return counts_[index];
+  }
+
+  double mean() const {
+    return mean_;
+  }
+
+  // Standard deviation of the sample, which is zero for a single value.
+  double stddev() const {
+    return count_ > 1 ? std::sqrt(squared_deviation_sum_ / (count_ - 1)) : 0;
+  }
+
+  void Clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    min_ = kMaxValue;
+    max_ = 0;
+    mean_ = 0;
+    squared_deviation_sum_ = 0;
+  }
+
+  void Record(long long value) {
+    if (value < 0) {
+      value = 0;
+    } else if (value > kMaxValue) {
+      value = kMaxValue;
+    }
+    ++counts_[GetBucketIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    // Welford's method.
+    const double delta = value - mean_;
+    mean_ += delta / count_;
+    squared_deviation_sum_ += delta * (value - mean_);
+  }
+
+  void Merge(const LatencyHistogram& histogram) {
+    if (!histogram.count_) return;
+    for (std::size_t i = 0; i < kNumBuckets; ++i) {
+      counts_[i] += histogram.counts_[i];
+    }
+    const long long count = count_ + histogram.count_;
+    const double delta = histogram.mean_ - mean_;
+    squared_deviation_sum_ += histogram.squared_deviation_sum_ +
+        delta * delta * count_ * histogram.count_ / count;
+    mean_ += delta * histogram.count_ / count;
+    count_ = count;
+    min_ = std::min(min_, histogram.min_);
+    max_ = std::max(max_, histogram.max_);
+  }
+
+  // Returns the smallest value at least the given fraction of the values are
+  // not greater than; e.g. quantile 0.99 is the 99th percentile.
+  long long GetValueAtQuantile(double quantile) const {
+    if (!count_) return 0;
+    const long long rank = std::max(
+        1LL, static_cast<long long>(std::ceil(quantile * count_)));
+    if (rank >= count_) return max_;
+    long long seen = 0;
+    for (std::size_t i = 0; i < kNumBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        const long long midpoint =
+            (GetBucketLowerBound(i) + GetBucketUpperBound(i)) / 2;
+        return std::min(std::max(midpoint, min()), max_);
+      }
+    }
+    return max_;
+  }
+
+  static std::size_t GetBucketIndex(long long value) {
+    if (value < (1LL << kSubBucketBits)) {
+      return static_cast<std::size_t>(value);
+    }
+    const int shift = GetMostSignificantBit(value) - (kSubBucketBits - 1);
+    const long long mantissa = value >> shift;
+    return static_cast<std::size_t>(
+        (1 << kSubBucketBits) + (shift - 1) * (1 << (kSubBucketBits - 1)) +
+        (mantissa - (1 << (kSubBucketBits - 1))));
+  }
+
+  static long long GetBucketLowerBound(std::size_t index) {
+    if (index < (1u << kSubBucketBits)) {
+      return index;
+    }
+    const std::size_t offset = index - (1 << kSubBucketBits);
+    const int shift =
+        static_cast<int>(offset >> (kSubBucketBits - 1)) + 1;
+    const long long mantissa = (1 << (kSubBucketBits - 1)) +
+        (offset & ((1 << (kSubBucketBits - 1)) - 1));
+    return mantissa << shift;
+  }
+
+  static long long GetBucketUpperBound(std::size_t index) {
+    return index + 1 < kNumBuckets ?
+        GetBucketLowerBound(index + 1) - 1 : kMaxValue;
+  }
+
+ private:
+  static int GetMostSignificantBit(long long value) {
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(static_cast<unsigned long long>(value));
+#else
+    int bit = 0;
+    while (value >>= 1) {
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+
+  std::vector<long long> counts_;
+  long long count_;
+  long long min_;
+  long long max_;
+  double mean_;
+  double squared_deviation_sum_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <cstddef>
+#include <gtest/gtest.h>
+#include "latency_histogram.h"
+
+namespace LOG {
+
+namespace {
+
+TEST(LatencyHistogramTest, BucketsCoverAllValues) {
+  EXPECT_EQ(0, LatencyHistogram::GetBucketLowerBound(0));
+  for (std::size_t i = 0; i + 1 < LatencyHistogram::kNumBuckets; ++i) {
+    const long long lower = LatencyHistogram::GetBucketLowerBound(i);
+    const long long upper = LatencyHistogram::GetBucketUpperBound(i);
+    ASSERT_LE(lower, upper);
+    ASSERT_EQ(upper + 1, LatencyHistogram::GetBucketLowerBound(i + 1));
+    ASSERT_EQ(i, LatencyHistogram::GetBucketIndex(lower));
+    ASSERT_EQ(i, LatencyHistogram::GetBucketIndex(upper));
+    ASSERT_LE(upper - lower, lower / 64);
+  }
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1,
+            LatencyHistogram::GetBucketIndex(LatencyHistogram::kMaxValue));
+}
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(0, histogram.max());
+  EXPECT_EQ(0, histogram.GetValueAtQuantile(0.5));
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 100; ++i) {
+    histogram.Record(i);
+  }
+  EXPECT_EQ(100, histogram.count());
+  EXPECT_EQ(1, histogram.min());
+  EXPECT_EQ(100, histogram.max());
+  EXPECT_DOUBLE_EQ(50.5, histogram.mean());
+  EXPECT_EQ(50, histogram.GetValueAtQuantile(0.5));
+  EXPECT_EQ(99, histogram.GetValueAtQuantile(0.99));
+  EXPECT_EQ(100, histogram.GetValueAtQuantile(1));
+}
+
+TEST(LatencyHistogramTest, LargeValuesAreApproximated) {
+  LatencyHistogram histogram;
+  for (long long i = 1; i <= 10000; ++i) {
+    histogram.Record(i * 1000000);
+  }
+  EXPECT_NEAR(5e9, histogram.GetValueAtQuantile(0.5), 5e9 / 64);
+  EXPECT_NEAR(9.9e9, histogram.GetValueAtQuantile(0.99), 9.9e9 / 64);
+  EXPECT_NEAR(9.99e9, histogram.GetValueAtQuantile(0.999), 9.99e9 / 64);
+  EXPECT_EQ(10000000000LL, histogram.GetValueAtQuantile(1));
+}
+
+TEST(LatencyHistogramTest, OutOfRangeValuesAreClamped) {
+  LatencyHistogram histogram;
+  histogram.Record(-1);
+  histogram.Record(LatencyHistogram::kMaxValue + 1);
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(LatencyHistogram::kMaxValue, histogram.max());
+}
+
+TEST(LatencyHistogramTest, Merge) {
+  LatencyHistogram histogram, even, odd;
+  for (int i = 0; i < 1000; ++i) {
+    histogram.Record(i * 997);
+    (i % 2 ? odd : even).Record(i * 997);
+  }
+  even.Merge(odd);
+  EXPECT_EQ(histogram.count(), even.count());
+  EXPECT_EQ(histogram.min(), even.min());
+  EXPECT_EQ(histogram.max(), even.max());
+  EXPECT_DOUBLE_EQ(histogram.mean(), even.mean());
+  EXPECT_NEAR(histogram.stddev(), even.stddev(), 1e-6);
+  EXPECT_EQ(histogram.GetValueAtQuantile(0.9), even.GetValueAtQuantile(0.9));
+}
+
+}  // namespace
+
+}  // namespace LOG
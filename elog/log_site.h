@@ -0,0 +1,122 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_LOG_SITE_H_
+#define ELOG_LOG_SITE_H_
+
+#include <cstddef>
+#include "atomic.h"
+#include "type_info.h"
+#include "util.h"
+
+namespace LOG {
+
+// Generation of the settings which decide whether a log statement is written:
+// the current logger, its level and its type verbosities. Decisions cached by
+// log sites are valid only while the generation is unchanged.
+template <AvoidODR>
+struct LogGenerationTemplate {
+  static volatile std::size_t value;
+};
+
+template <AvoidODR N>
+volatile std::size_t LogGenerationTemplate<N>::value = 1;
+
+typedef LogGenerationTemplate<AVOID_ODR> LogGeneration;
+
+inline std::size_t GetLogGeneration() {
+  return LogGeneration::value;
+}
+
+inline void InvalidateLogSites() {
+  FetchAndAdd(LogGeneration::value, 1);
+}
+
+// Descriptor of each LOG(type, verbosity) statement. It is a POD initialized
+// at compile time, and is filled in and registered to the list of sites the
+// first time the statement runs. It caches the verbosity of its type in the
+// current logger, so that a disabled statement costs a few loads.
+struct TypedLogSite {
+  TypeInfo (*get_type_info)();
+
+  // Generation of type_verbosity; zero if not cached yet, and
+  // kRefreshingLogSite while a thread is storing them.
+  volatile std::size_t generation;
+  volatile int type_verbosity;
+
+  volatile int is_registered;
+  std::size_t id;
+  const char* source_file_name;
+  int line_number;
+  int verbosity;
+  TypedLogSite* next;
+};
+
+static const std::size_t kRefreshingLogSite = static_cast<std::size_t>(-1);
+
+template <AvoidODR>
+struct TypedLogSiteListTemplate {
+  static TypedLogSite* volatile head;
+  static volatile std::size_t size;
+};
+
+template <AvoidODR N>
+TypedLogSite* volatile TypedLogSiteListTemplate<N>::head;
+
+template <AvoidODR N>
+volatile std::size_t TypedLogSiteListTemplate<N>::size;
+
+typedef TypedLogSiteListTemplate<AVOID_ODR> TypedLogSiteList;
+
+// Returns the most recently registered site. Follow TypedLogSite::next for
+// the others.
+inline const TypedLogSite* GetTypedLogSites() {
+  return TypedLogSiteList::head;
+}
+
+inline void RegisterTypedLogSite(TypedLogSite& site,
+                                 int verbosity,
+                                 const char* source_file_name,
+                                 int line_number) {
+  if (site.is_registered ||
+      CompareAndSwap(site.is_registered, 0, 1) != 0) {
+    return;
+  }
+  site.id = FetchAndAdd(TypedLogSiteList::size, 1);
+  site.source_file_name = source_file_name;
+  site.line_number = line_number;
+  site.verbosity = verbosity;
+  for (;;) {
+    TypedLogSite* const head = TypedLogSiteList::head;
+    site.next = head;
+    if (CompareAndSwap(TypedLogSiteList::head, head, &site) == head) break;
+  }
+}
+
+namespace {
+
+// Distinct in each translation unit, so that TypedLogSiteHolder has one
+// instance per statement even if statements in different files share the
+// type and the line number.
+struct TranslationUnitTag {};
+
+}  // anonymous namespace
+
+template <typename T, typename TranslationUnit, int LINE>
+struct TypedLogSiteHolder {
+  static TypeInfo GetTypeInfo() {
+    return TypeInfo(Type<T>());
+  }
+
+  static TypedLogSite site;
+};
+
+template <typename T, typename TranslationUnit, int LINE>
+TypedLogSite TypedLogSiteHolder<T, TranslationUnit, LINE>::site = {
+  &TypedLogSiteHolder<T, TranslationUnit, LINE>::GetTypeInfo,
+  0, 0, 0, 0, NULL, 0, 0, NULL
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_LOG_SITE_H_
@@ -4,6 +4,8 @@
 #ifndef ELOG_LOGGER_H_
 #define ELOG_LOGGER_H_
 
+#include <climits>
+#include <cstddef>
 #include <exception>
 #include <string>
 
@@ -13,6 +15,7 @@
 # undef ERROR
 #endif
 
+#include "log_site.h"
 #include "type_info.h"
 #include "util.h"
 
@@ -65,8 +68,7 @@ class Logger {
   static void OutputTypedMessageHeader(TypeInfo type_info,
                                        int verbosity,
                                        OutputStream& stream) {
-    const Demangle demangle = type_info.GetTypeName();
-    stream << "[" << demangle.GetName() << "(" << verbosity << ")] ";
+    stream << "[" << type_info.GetName() << "(" << verbosity << ")] ";
   }
 
   template <typename OutputStream>
@@ -76,8 +78,34 @@ class Logger {
     stream << source_file_name << "(" << line_number << "): ";
   }
 
+  Logger()
+      : level_(INFO) {
+  }
+
   virtual ~Logger() {}
 
+  // Messages less severe than this level are discarded. LOG() reads it before
+  // building the message, so a discarded statement costs only this load.
+  LogLevel level() const {
+    return level_;
+  }
+
+  void set_level(LogLevel level) {
+    level_ = level;
+    InvalidateLogSites();
+  }
+
+  bool IsLevelEnabled(LogLevel log_level) const {
+    return IsLogLevelSevereEnough(log_level, level_);
+  }
+
+  // Typed messages with verbosity greater than the returned value are
+  // discarded. LOG(type, verbosity) caches the value in its TypedLogSite, so
+  // loggers must call InvalidateLogSites() when it changes.
+  virtual int GetTypeVerbosity(TypeInfo) const {
+    return INT_MAX;
+  }
+
   virtual void PushRawMessage(LogLevel level, const std::string& message) = 0;
 
   virtual void PushMessage(LogLevel level,
@@ -85,6 +113,18 @@ class Logger {
                            int line_number,
                            const std::string& message) = 0;
 
+  // Same as PushMessage() taking std::string. Loggers which can write the
+  // message without copying it should override this, so that LOG() does not
+  // allocate memory.
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const char* message,
+                           std::size_t message_size) {
+    PushMessage(level, source_file_name, line_number,
+                std::string(message, message_size));
+  }
+
   virtual void PushFatalMessageAndThrow(const char* source_file_name,
                                         int line_number,
                                         const std::string& message) = 0;
@@ -98,6 +138,20 @@ class Logger {
                                 const char* source_file_name,
                                 int line_number,
                                 const std::string& message) = 0;
+
+  // Same as PushTypedMessage() taking std::string.
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const char* message,
+                                std::size_t message_size) {
+    PushTypedMessage(type_info, verbosity, source_file_name, line_number,
+                     std::string(message, message_size));
+  }
+
+ private:
+  volatile LogLevel level_;
 };
 
 }  // namespace LOG
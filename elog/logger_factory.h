@@ -5,6 +5,7 @@
 #define ELOG_LOGGER_FACTORY_H_
 
 #include "atomic.h"
+#include "log_site.h"
 #include "singleton.h"
 #include "stream_logger.h"
 #include "util.h"
@@ -23,6 +24,7 @@ class LoggerFactory : Noncopyable {
 
   void set_logger(Logger& logger) {
     AtomicSet(logger_, &logger);
+    InvalidateLogSites();
   }
 
   void Reset() {
@@ -49,6 +51,13 @@ inline void UseDefaultLogger() {
   Singleton<LoggerFactory>::Get().Reset();
 }
 
+// Returns whether the current logger writes messages of LEVEL. FATAL and CHECK
+// are always enabled, because they throw regardless of the logger level.
+template <LogLevel LEVEL>
+inline bool IsLogLevelEnabled() {
+  return LEVEL >= FATAL || GetLogger().IsLevelEnabled(LEVEL);
+}
+
 
 inline void SetDefaultLoggerLevel(LogLevel level) {
   Singleton<StreamLogger>::Get().set_level(level);
@@ -0,0 +1,21 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_MAPPED_FILE_H_
+#define ELOG_MAPPED_FILE_H_
+
+#include <exception>
+
+namespace LOG {
+
+struct MappedFileError : virtual std::exception {};
+
+}  // namespace LOG
+
+#ifdef _WIN32
+# include "mapped_file_win32.h"
+#else
+# include "mapped_file_posix.h"
+#endif
+
+#endif  // ELOG_MAPPED_FILE_H_
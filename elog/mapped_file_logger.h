@@ -0,0 +1,283 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_MAPPED_FILE_LOGGER_H_
+#define ELOG_MAPPED_FILE_LOGGER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "atomic.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "message_stream.h"
+#include "mutex.h"
+#include "thread.h"
+#include "util.h"
+#include "verbosity_table.h"
+
+namespace LOG {
+
+// Header at the beginning of each segment file of MappedFileLogger. The
+// messages follow it. committed_length is updated after each message is
+// written, so that it is valid even if the process crashes.
+struct MappedLogHeader {
+  char magic[8];  // "ELOGMAP1"
+  volatile unsigned long long committed_length;
+};
+
+// Logger which writes messages in the format of StreamLogger directly into
+// memory-mapped files, without system calls or locks on each message. The log
+// is split into segments of fixed size named "<path>.0", "<path>.1", ...,
+// which are preallocated when opened and shrunk to the committed length when
+// closed. The kernel writes the pages back lazily; call Flush() to wait for
+// it. FATAL and CHECK messages are flushed before throwing.
+//
+// Each thread reserves space in the current segment by an atomic add on the
+// write offset, copies the header built on its stack and its message, and then
+// commits it in the order of the reservation. The thread whose message crosses
+// the end of the segment opens the next one. Messages longer than a segment
+// are truncated. Segments smaller than the header and one byte of messages are
+// enlarged to that size.
+class MappedFileLogger : public Logger, Noncopyable {
+ public:
+  static const std::size_t kDefaultSegmentSize = 64 << 20;
+
+  explicit MappedFileLogger(const std::string& path,
+                            std::size_t segment_size = kDefaultSegmentSize)
+      : path_(path),
+        segment_size_(std::max(segment_size, sizeof(MappedLogHeader) + 1)),
+        segment_index_(0),
+        segment_(new Segment(GetSegmentPath(0).c_str(), segment_size_)) {
+  }
+
+  virtual ~MappedFileLogger() {
+    segment_->Close();
+    delete segment_;
+    std::for_each(retired_segments_.begin(), retired_segments_.end(),
+                  CheckedDelete<Segment>);
+  }
+
+  std::string GetSegmentPath(int segment_index) const {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%d", segment_index);
+    return path_ + suffix;
+  }
+
+  // Index of the segment currently written.
+  int segment_index() const {
+    return segment_index_;
+  }
+
+  // Waits until the committed messages are written to the file.
+  void Flush() {
+    MutexLock lock(rotation_mutex_);
+    segment_->file.Sync();
+  }
+
+  template <typename T>
+  void SetTypeVerbosity(int verbosity) {
+    SetTypeVerbosity(TypeInfo(Type<T>()), verbosity);
+  }
+
+  void SetTypeVerbosity(TypeInfo type_info, int verbosity) {
+    verbosities_.Set(type_info, verbosity);
+  }
+
+  void ResetVerbosities() {
+    verbosities_.Clear();
+  }
+
+  virtual int GetTypeVerbosity(TypeInfo type_info) const {
+    return verbosities_.Get(type_info);
+  }
+
+  virtual void PushRawMessage(LogLevel level, const std::string& message) {
+    if (!IsLevelEnabled(level)) return;
+    Append("", 0, message.data(), message.size());
+  }
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const std::string& message) {
+    PushMessage(level, source_file_name, line_number,
+                message.data(), message.size());
+  }
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const char* message,
+                           std::size_t message_size) {
+    if (!IsLevelEnabled(level)) return;
+    PushMessageWithoutCheck(level, source_file_name, line_number,
+                            message, message_size);
+  }
+
+  virtual void PushFatalMessageAndThrow(const char* source_file_name,
+                                        int line_number,
+                                        const std::string& message) {
+    PushMessageWithoutCheck(FATAL, source_file_name, line_number,
+                            message.data(), message.size());
+    Flush();
+    throw FatalLogError();
+  }
+
+  virtual void PushCheckMessageAndThrow(const char* source_file_name,
+                                        int line_number,
+                                        const std::string& message) {
+    PushMessageWithoutCheck(CHECK, source_file_name, line_number,
+                            message.data(), message.size());
+    Flush();
+    throw CheckError();
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const std::string& message) {
+    PushTypedMessage(type_info, verbosity, source_file_name, line_number,
+                     message.data(), message.size());
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const char* message,
+                                std::size_t message_size) {
+    const int type_verbosity = verbosities_.Get(type_info);
+    if (IsVerboseEnough(verbosity, type_verbosity)) return;
+    char buffer[kHeaderBufferSize];
+    MessageStream header(buffer, sizeof(buffer));
+    OutputTypedMessageHeader(type_info, verbosity, header);
+    OutputFileLine(source_file_name, line_number, header);
+    Append(header.data(), header.size(), message, message_size);
+  }
+
+ private:
+  // Enough for the headers but of long file or type names, which spill to
+  // the heap.
+  static const std::size_t kHeaderBufferSize = 256;
+
+  struct Segment {
+    Segment(const char* path, std::size_t size)
+        : file(path, size),
+          header(reinterpret_cast<MappedLogHeader*>(file.data())),
+          data(file.data() + sizeof(MappedLogHeader)),
+          capacity(size - sizeof(MappedLogHeader)),
+          reserved_length(0),
+          committed_length(0) {
+      std::memcpy(header->magic, "ELOGMAP1", sizeof(header->magic));
+      header->committed_length = 0;
+    }
+
+    void Close() {
+      file.Close(sizeof(MappedLogHeader) + committed_length);
+    }
+
+    MappedFile file;
+    MappedLogHeader* header;
+    char* data;
+    std::size_t capacity;
+    volatile std::size_t reserved_length;
+    volatile std::size_t committed_length;
+  };
+
+  void PushMessageWithoutCheck(LogLevel level,
+                               const char* source_file_name,
+                               int line_number,
+                               const char* message,
+                               std::size_t message_size) {
+    char buffer[kHeaderBufferSize];
+    MessageStream header(buffer, sizeof(buffer));
+    OutputLogLevelName(level, header);
+    OutputFileLine(source_file_name, line_number, header);
+    Append(header.data(), header.size(), message, message_size);
+  }
+
+  // Appends the header, the message and a newline as a line.
+  void Append(const char* header,
+              std::size_t header_size,
+              const char* message,
+              std::size_t message_size) {
+    for (;;) {
+      Segment* segment = segment_;
+      const std::size_t size = std::min(header_size + message_size + 1,
+                                        segment->capacity);
+      const std::size_t position = FetchAndAdd(segment->reserved_length, size);
+      if (position + size <= segment->capacity) {
+        CopyLine(header, header_size, message, message_size,
+                 segment->data + position, size);
+        Commit(*segment, position, size);
+        return;
+      }
+
+      if (position <= segment->capacity) {
+        // This message crosses the end, so no other thread rotates.
+        WaitForCommit(*segment, position);
+        Rotate(segment);
+      } else {
+        while (segment_ == segment) {
+          YieldThread();
+        }
+      }
+    }
+  }
+
+  // Copies the line truncated to the size.
+  static void CopyLine(const char* header,
+                       std::size_t header_size,
+                       const char* message,
+                       std::size_t message_size,
+                       char* line,
+                       std::size_t size) {
+    header_size = std::min(header_size, size);
+    std::memcpy(line, header, header_size);
+    message_size = std::min(message_size, size - header_size);
+    std::memcpy(line + header_size, message, message_size);
+    if (header_size + message_size < size) {
+      line[header_size + message_size] = '\n';
+    }
+  }
+
+  static void WaitForCommit(const Segment& segment, std::size_t position) {
+    while (segment.committed_length != position) {
+      YieldThread();
+    }
+    AtomicFence();
+  }
+
+  static void Commit(Segment& segment, std::size_t position, std::size_t size) {
+    WaitForCommit(segment, position);
+    segment.header->committed_length = position + size;
+    segment.committed_length = position + size;
+  }
+
+  void Rotate(Segment* segment) {
+    MutexLock lock(rotation_mutex_);
+    Segment* next_segment =
+        new Segment(GetSegmentPath(segment_index_ + 1).c_str(), segment_size_);
+    segment->Close();
+    retired_segments_.push_back(segment);
+    ++segment_index_;
+    AtomicSet(segment_, next_segment);
+  }
+
+  const std::string path_;
+  const std::size_t segment_size_;
+  volatile int segment_index_;
+  Segment* volatile segment_;
+  std::vector<Segment*> retired_segments_;
+  Mutex rotation_mutex_;
+  VerbosityTable verbosities_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_MAPPED_FILE_LOGGER_H_
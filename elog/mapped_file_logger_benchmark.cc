@@ -0,0 +1,78 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the throughput of writing messages to a file by StreamLogger on
+// std::ofstream and by MappedFileLogger, with several threads.
+
+#include "config.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include "mapped_file_logger.h"
+#include "stream_logger.h"
+#include "thread.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumMessages = 200000;
+const int kMaxNumThreads = 4;
+const char* kPath = "mapped_file_logger_benchmark.log";
+
+void PushMessages(LOG::Logger* logger, int count) {
+  for (int i = 0; i < count; ++i) {
+    logger->PushMessage(LOG::INFO, __FILE__, __LINE__,
+                        "a message of typical length", 27);
+  }
+}
+
+double RunThreads(LOG::Logger& logger, int num_threads) {
+  LOG::Timer timer;
+  std::vector<LOG::Thread*> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(new LOG::Thread(std::tr1::bind(
+        PushMessages, &logger, kNumMessages / num_threads)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  return timer.GetTime();
+}
+
+void PrintThroughput(const char* title, int num_threads, double time) {
+  std::cout << title << " (" << num_threads << " threads): "
+            << kNumMessages / time << " messages/sec" << std::endl;
+}
+
+}  // anonymous namespace
+
+int main() {
+  for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+    {
+      std::ofstream file(kPath);
+      LOG::StreamLogger logger(file);
+      PrintThroughput("StreamLogger", num_threads,
+                      RunThreads(logger, num_threads));
+    }
+    std::remove(kPath);
+
+    {
+      LOG::MappedFileLogger logger(kPath, 4 << 20);
+      PrintThroughput("MappedFileLogger", num_threads,
+                      RunThreads(logger, num_threads));
+      for (int i = 0; i <= logger.segment_index(); ++i) {
+        std::remove(logger.GetSegmentPath(i).c_str());
+      }
+    }
+  }
+  return 0;
+}
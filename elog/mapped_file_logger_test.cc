@@ -0,0 +1,251 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include <gtest/gtest.h>
+#include "elog.h"
+#include "mapped_file_logger.h"
+#include "thread.h"
+
+namespace {
+
+volatile std::size_t allocation_count = 0;
+
+// Not inlined, so that the compiler does not pair malloc in operator new with
+// free in operator delete.
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void Deallocate(void* ptr) {
+  std::free(ptr);
+}
+
+}  // anonymous namespace
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) throw() {
+  Deallocate(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* ptr, std::size_t) throw() {
+  Deallocate(ptr);
+}
+#endif
+
+namespace LOG {
+
+namespace {
+
+const char* kPath = "mapped_file_logger_test.log";
+const char* kSourceFileName = "source file name";
+const int kLineNumber = 10;
+
+class SomeModule {};
+
+// Returns the committed messages of the segment file.
+std::string ReadSegment(const std::string& path) {
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  const std::string data = contents.str();
+  if (data.size() < sizeof(MappedLogHeader)) return "";
+
+  MappedLogHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  EXPECT_EQ(0, std::memcmp(header.magic, "ELOGMAP1", sizeof(header.magic)));
+  return data.substr(sizeof(header), header.committed_length);
+}
+
+std::size_t CountLines(const std::string& text) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') ++count;
+  }
+  return count;
+}
+
+void RemoveSegments(const MappedFileLogger& logger) {
+  for (int i = 0; i <= logger.segment_index(); ++i) {
+    std::remove(logger.GetSegmentPath(i).c_str());
+  }
+}
+
+void PushMessages(MappedFileLogger* logger, int count) {
+  for (int i = 0; i < count; ++i) {
+    logger->PushMessage(INFO, kSourceFileName, kLineNumber, "message");
+  }
+}
+
+}  // anonymous namespace
+
+TEST(MappedFileLoggerTest, PushMessage) {
+  MappedFileLogger logger(kPath, 4096);
+  logger.PushMessage(WARN, kSourceFileName, kLineNumber, "message");
+  logger.PushTypedMessage(TypeInfo(Type<SomeModule>()), 0,
+                          kSourceFileName, kLineNumber, "typed");
+
+  EXPECT_EQ("[WARN] source file name(10): message\n"
+            "[LOG::(anonymous namespace)::SomeModule(0)] "
+            "source file name(10): typed\n",
+            ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, PushRawMessage) {
+  MappedFileLogger logger(kPath, 4096);
+  logger.PushRawMessage(INFO, "raw");
+  EXPECT_EQ("raw\n", ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, LongHeader) {
+  MappedFileLogger logger(kPath, 4096);
+  const std::string source_file_name(1000, 'a');
+  logger.PushMessage(INFO, source_file_name.c_str(), kLineNumber, "message");
+  EXPECT_EQ("[INFO] " + source_file_name + "(10): message\n",
+            ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, LongMessageIsTruncated) {
+  const std::size_t capacity = 64;
+  MappedFileLogger logger(kPath, sizeof(MappedLogHeader) + capacity);
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber,
+                     std::string(capacity, 'x'));
+  const std::string header = "[INFO] source file name(10): ";
+  EXPECT_EQ(header + std::string(capacity - header.size(), 'x'),
+            ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, TooSmallSegmentIsEnlarged) {
+  MappedFileLogger logger(kPath, 1);
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber, "message");
+  EXPECT_EQ("[", ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, LogWithoutAllocation) {
+  MappedFileLogger logger(kPath, 1 << 20);
+  SetLogger(logger);
+  LOG() << "warm up";
+  LOG(SomeModule, 0) << "warm up";
+
+  const std::string value = "value";
+  const std::size_t initial_allocation_count = allocation_count;
+  for (int i = 0; i < 100; ++i) {
+    LOG() << value << ": " << i;
+    LOG(SomeModule, 0) << value << ": " << i;
+  }
+  EXPECT_EQ(initial_allocation_count, allocation_count);
+
+  UseDefaultLogger();
+  EXPECT_EQ(202u, CountLines(ReadSegment(logger.GetSegmentPath(0))));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, FilterMessages) {
+  MappedFileLogger logger(kPath, 4096);
+  logger.set_level(WARN);
+  logger.SetTypeVerbosity<SomeModule>(1);
+  logger.PushMessage(INFO, kSourceFileName, kLineNumber, "info");
+  logger.PushTypedMessage(TypeInfo(Type<SomeModule>()), 2,
+                          kSourceFileName, kLineNumber, "verbose");
+
+  EXPECT_EQ("", ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, FileIsShrunkOnClose) {
+  std::string path;
+  {
+    MappedFileLogger logger(kPath, 4096);
+    logger.PushMessage(INFO, kSourceFileName, kLineNumber, "message");
+    path = logger.GetSegmentPath(0);
+  }
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  file.seekg(0, std::ios::end);
+  EXPECT_EQ(static_cast<std::streamoff>(
+                sizeof(MappedLogHeader) +
+                sizeof("[INFO] source file name(10): message\n") - 1),
+            static_cast<std::streamoff>(file.tellg()));
+  std::remove(path.c_str());
+}
+
+TEST(MappedFileLoggerTest, Rotate) {
+  MappedFileLogger logger(kPath, 1024);
+  PushMessages(&logger, 100);
+  ASSERT_LT(0, logger.segment_index());
+
+  std::string messages;
+  for (int i = 0; i <= logger.segment_index(); ++i) {
+    const std::string segment = ReadSegment(logger.GetSegmentPath(i));
+    EXPECT_LE(segment.size(), 1024 - sizeof(MappedLogHeader));
+    messages += segment;
+  }
+  EXPECT_EQ(100u, CountLines(messages));
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, MultipleThreads) {
+  static const int kNumThreads = 4;
+  static const int kNumMessages = 1000;
+
+  MappedFileLogger logger(kPath, 4096);
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(PushMessages, &logger, kNumMessages)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  std::string messages;
+  for (int i = 0; i <= logger.segment_index(); ++i) {
+    messages += ReadSegment(logger.GetSegmentPath(i));
+  }
+  EXPECT_EQ(static_cast<std::size_t>(kNumThreads * kNumMessages),
+            CountLines(messages));
+  const std::string line = "[INFO] source file name(10): message\n";
+  for (std::size_t i = 0; i < messages.size(); i += line.size()) {
+    ASSERT_EQ(line, messages.substr(i, line.size()));
+  }
+  RemoveSegments(logger);
+}
+
+TEST(MappedFileLoggerTest, FatalFlushesBeforeThrow) {
+  MappedFileLogger logger(kPath, 4096);
+  EXPECT_THROW(
+      logger.PushFatalMessageAndThrow(kSourceFileName, kLineNumber, "fatal"),
+      FatalLogError);
+  EXPECT_EQ("[FATAL] source file name(10): fatal\n",
+            ReadSegment(logger.GetSegmentPath(0)));
+  RemoveSegments(logger);
+}
+
+}  // namespace LOG
@@ -0,0 +1,78 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_MAPPED_FILE_POSIX_H_
+#define ELOG_MAPPED_FILE_POSIX_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include "util.h"
+
+namespace LOG {
+
+// File of fixed size mapped to memory for writing. The file is created or
+// truncated, and its blocks are allocated up front. Throws MappedFileError
+// on failure.
+class MappedFile : Noncopyable {
+ public:
+  MappedFile(const char* path, std::size_t size)
+      : data_(NULL),
+        size_(size),
+        fd_(open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) {
+    if (fd_ < 0) throw MappedFileError();
+    if (ftruncate(fd_, size) != 0) {
+      close(fd_);
+      throw MappedFileError();
+    }
+    // Failure only means that the blocks are allocated lazily.
+    posix_fallocate(fd_, 0, size);
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      close(fd_);
+      throw MappedFileError();
+    }
+    data_ = static_cast<char*>(data);
+  }
+
+  ~MappedFile() {
+    if (data_) {
+      Close(size_);
+    }
+  }
+
+  char* data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  // Writes the modified pages back to the file and waits for completion.
+  void Sync() {
+    msync(data_, size_, MS_SYNC);
+  }
+
+  // Unmaps the file and shrinks it to the given size.
+  void Close(std::size_t file_size) {
+    munmap(data_, size_);
+    data_ = NULL;
+    // On failure the rest of the file is left filled with zeros.
+    const int result = ftruncate(fd_, file_size);
+    (void) result;
+    close(fd_);
+  }
+
+ private:
+  char* data_;
+  std::size_t size_;
+  int fd_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_MAPPED_FILE_POSIX_H_
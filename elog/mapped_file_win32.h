@@ -0,0 +1,82 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_MAPPED_FILE_WIN32_H_
+#define ELOG_MAPPED_FILE_WIN32_H_
+
+#include <windows.h>
+#include <cstddef>
+#include "util.h"
+
+namespace LOG {
+
+// File of fixed size mapped to memory for writing. The file is created or
+// truncated to the size. Throws MappedFileError on failure.
+class MappedFile : Noncopyable {
+ public:
+  MappedFile(const char* path, std::size_t size)
+      : data_(NULL),
+        size_(size),
+        file_(CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                          NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)),
+        mapping_(NULL) {
+    if (file_ == INVALID_HANDLE_VALUE) throw MappedFileError();
+    const unsigned long long size64 = size;
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READWRITE,
+                                  static_cast<DWORD>(size64 >> 32),
+                                  static_cast<DWORD>(size64), NULL);
+    if (!mapping_) {
+      CloseHandle(file_);
+      throw MappedFileError();
+    }
+    data_ = static_cast<char*>(
+        MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size));
+    if (!data_) {
+      CloseHandle(mapping_);
+      CloseHandle(file_);
+      throw MappedFileError();
+    }
+  }
+
+  ~MappedFile() {
+    if (data_) {
+      Close(size_);
+    }
+  }
+
+  char* data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  // Writes the modified pages back to the file and waits for completion.
+  void Sync() {
+    FlushViewOfFile(data_, size_);
+    FlushFileBuffers(file_);
+  }
+
+  // Unmaps the file and shrinks it to the given size.
+  void Close(std::size_t file_size) {
+    UnmapViewOfFile(data_);
+    data_ = NULL;
+    CloseHandle(mapping_);
+    LARGE_INTEGER position;
+    position.QuadPart = file_size;
+    SetFilePointerEx(file_, position, NULL, FILE_BEGIN);
+    SetEndOfFile(file_);
+    CloseHandle(file_);
+  }
+
+ private:
+  char* data_;
+  std::size_t size_;
+  HANDLE file_;
+  HANDLE mapping_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_MAPPED_FILE_WIN32_H_
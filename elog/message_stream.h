@@ -0,0 +1,291 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_MESSAGE_STREAM_H_
+#define ELOG_MESSAGE_STREAM_H_
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ios>
+#include <sstream>
+#include <string>
+#include "number_format.h"
+#include "put_as_string.h"
+#include "util.h"
+
+namespace LOG {
+
+template <AvoidODR>
+struct MessageBufferTemplate {
+  static const std::size_t kSize = 4096;
+
+  static ELOG_I_THREAD_LOCAL char buffer[kSize];
+  static ELOG_I_THREAD_LOCAL bool is_in_use;
+};
+
+template <AvoidODR N>
+ELOG_I_THREAD_LOCAL char MessageBufferTemplate<N>::buffer[kSize];
+
+template <AvoidODR N>
+ELOG_I_THREAD_LOCAL bool MessageBufferTemplate<N>::is_in_use;
+
+typedef MessageBufferTemplate<AVOID_ODR> MessageBuffer;
+
+// Output stream building a log message without heap allocation. The first
+// write borrows a buffer owned by the current thread, which is returned when
+// the stream is destroyed, unless the stream is given its own buffer. Longer
+// messages, and messages built while another stream of the thread holds the
+// buffer, spill to the heap.
+//
+// Characters, strings, numbers and pointers are formatted as std::ostream does
+// by default. Other types and manipulators go through a std::ostringstream
+// created on demand, which keeps the formatting state of the stream.
+class MessageStream : Noncopyable {
+ public:
+  MessageStream()
+      : data_(NULL),
+        size_(0),
+        capacity_(0),
+        owns_thread_buffer_(false),
+        formatter_(NULL) {
+  }
+
+  // Writes into the buffer, e.g. an array on the stack of the caller, so that
+  // a logger can build a line while LOG() holds the buffer of the thread.
+  MessageStream(char* buffer, std::size_t capacity)
+      : data_(buffer),
+        size_(0),
+        capacity_(capacity),
+        owns_thread_buffer_(false),
+        formatter_(NULL) {
+  }
+
+  ~MessageStream() {
+    if (owns_thread_buffer_) {
+      MessageBuffer::is_in_use = false;
+    }
+    delete formatter_;
+  }
+
+  const char* data() const {
+    return data_ ? data_ : "";
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  std::string str() const {
+    return std::string(data(), size_);
+  }
+
+  MessageStream& write(const char* s, std::size_t n) {
+    if (n == 0) return *this;
+    if (size_ + n > capacity_) {
+      Reserve(size_ + n);
+    }
+    std::memcpy(data_ + size_, s, n);
+    size_ += n;
+    return *this;
+  }
+
+  MessageStream& put(char c) {
+    return write(&c, 1);
+  }
+
+  PrintState& print_state() {
+    return print_state_;
+  }
+
+  MessageStream& operator<<(char c) {
+    return IsFormatted() ? Format(c) : put(c);
+  }
+
+  MessageStream& operator<<(signed char c) {
+    return IsFormatted() ? Format(c) : put(static_cast<char>(c));
+  }
+
+  MessageStream& operator<<(unsigned char c) {
+    return IsFormatted() ? Format(c) : put(static_cast<char>(c));
+  }
+
+  // A null pointer is written as "(null)", where std::ostream would set
+  // badbit and drop the rest of the message.
+  MessageStream& operator<<(const char* s) {
+    if (!s) return write("(null)", 6);
+    return IsFormatted() ? Format(s) : write(s, std::strlen(s));
+  }
+
+  MessageStream& operator<<(const std::string& s) {
+    return IsFormatted() ? Format(s) : write(s.data(), s.size());
+  }
+
+  MessageStream& operator<<(bool b) {
+    return IsFormatted() ? Format(b) : put(b ? '1' : '0');
+  }
+
+  MessageStream& operator<<(short n) {
+    return IsFormatted() ? Format(n) : WriteSigned(n);
+  }
+
+  MessageStream& operator<<(unsigned short n) {
+    return IsFormatted() ? Format(n) : WriteUnsigned(n);
+  }
+
+  MessageStream& operator<<(int n) {
+    return IsFormatted() ? Format(n) : WriteSigned(n);
+  }
+
+  MessageStream& operator<<(unsigned int n) {
+    return IsFormatted() ? Format(n) : WriteUnsigned(n);
+  }
+
+  MessageStream& operator<<(long n) {
+    return IsFormatted() ? Format(n) : WriteSigned(n);
+  }
+
+  MessageStream& operator<<(unsigned long n) {
+    return IsFormatted() ? Format(n) : WriteUnsigned(n);
+  }
+
+  MessageStream& operator<<(long long n) {
+    return IsFormatted() ? Format(n) : WriteSigned(n);
+  }
+
+  MessageStream& operator<<(unsigned long long n) {
+    return IsFormatted() ? Format(n) : WriteUnsigned(n);
+  }
+
+  MessageStream& operator<<(float x) {
+    return IsFormatted() ? Format(x) : WriteDouble(x);
+  }
+
+  MessageStream& operator<<(double x) {
+    return IsFormatted() ? Format(x) : WriteDouble(x);
+  }
+
+  MessageStream& operator<<(long double x) {
+    return IsFormatted() ? Format(x) : WritePrintf("%Lg", x);
+  }
+
+  MessageStream& operator<<(const void* p) {
+    if (IsFormatted()) return Format(p);
+    return p ? WritePrintf("%p", p) : put('0');
+  }
+
+  MessageStream& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+    return Format(manipulator);
+  }
+
+  MessageStream& operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+    return Format(manipulator);
+  }
+
+  template <typename T>
+  MessageStream& operator<<(const T& t) {
+    return Format(t);
+  }
+
+ private:
+  void Reserve(std::size_t required_size) {
+    if (!data_ && !MessageBuffer::is_in_use) {
+      MessageBuffer::is_in_use = true;
+      owns_thread_buffer_ = true;
+      data_ = MessageBuffer::buffer;
+      capacity_ = MessageBuffer::kSize;
+      if (required_size <= capacity_) return;
+    }
+
+    std::size_t new_capacity =
+        capacity_ ? capacity_ * 2 : MessageBuffer::kSize;
+    while (new_capacity < required_size) {
+      new_capacity *= 2;
+    }
+    const bool is_on_heap = !heap_buffer_.empty();
+    if (!is_on_heap) {
+      heap_buffer_.assign(data(), size_);
+    }
+    heap_buffer_.resize(new_capacity);
+    data_ = &heap_buffer_[0];
+    capacity_ = new_capacity;
+
+    if (owns_thread_buffer_) {
+      MessageBuffer::is_in_use = false;
+      owns_thread_buffer_ = false;
+    }
+  }
+
+  template <typename Unsigned>
+  MessageStream& WriteUnsigned(Unsigned n) {
+    char digits[kMaxUnsignedDigits];
+    char* const end = digits + sizeof(digits);
+    const char* const begin = FormatUnsigned(n, end);
+    return write(begin, end - begin);
+  }
+
+  template <typename Signed>
+  MessageStream& WriteSigned(Signed n) {
+    if (n >= 0) {
+      return WriteUnsigned(static_cast<unsigned long long>(n));
+    }
+    put('-');
+    return WriteUnsigned(0ULL - static_cast<unsigned long long>(n));
+  }
+
+  // Values of short digits are formatted without printf.
+  MessageStream& WriteDouble(double x) {
+    char buffer[kMaxGeneralDoubleSize];
+    const std::size_t size = FormatGeneralDouble(x, buffer);
+    return size ? write(buffer, size) : WritePrintf("%g", x);
+  }
+
+  template <typename T>
+  MessageStream& WritePrintf(const char* format, T value) {
+    char buffer[64];
+    const int length = std::snprintf(buffer, sizeof(buffer), format, value);
+    return write(buffer, length);
+  }
+
+  // Returns whether the formatting state differs from the default one, in
+  // which case values must be formatted by the std::ostringstream.
+  bool IsFormatted() const {
+    return formatter_ &&
+        (formatter_->flags() != (std::ios_base::dec | std::ios_base::skipws) ||
+         formatter_->precision() != 6 ||
+         formatter_->width() != 0);
+  }
+
+  template <typename T>
+  MessageStream& Format(const T& t) {
+    if (!formatter_) {
+      formatter_ = new std::ostringstream;
+    }
+    *formatter_ << t;
+    const std::string formatted = formatter_->str();
+    formatter_->str("");
+    return write(formatted.data(), formatted.size());
+  }
+
+  char* data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  bool owns_thread_buffer_;
+  std::string heap_buffer_;
+  std::ostringstream* formatter_;
+  PrintState print_state_;
+};
+
+inline PrintState* GetPrintState(MessageStream& stream) {
+  return &stream.print_state();
+}
+
+inline std::size_t GetPrintedSize(const MessageStream& stream) {
+  return stream.size();
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_MESSAGE_STREAM_H_
@@ -0,0 +1,79 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the throughput of building log messages with std::ostringstream,
+// which GeneralLog used, and with MessageStream.
+
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "elog.h"
+#include "message_stream.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+
+// Logger which discards everything, to exclude the cost of output.
+class NullLogger : public LOG::Logger {
+ public:
+  virtual void PushRawMessage(LOG::LogLevel, const std::string&) {}
+  virtual void PushMessage(LOG::LogLevel, const char*, int,
+                           const std::string&) {}
+  virtual void PushMessage(LOG::LogLevel, const char*, int,
+                           const char*, std::size_t) {}
+  virtual void PushFatalMessageAndThrow(const char*, int,
+                                        const std::string&) {}
+  virtual void PushCheckMessageAndThrow(const char*, int,
+                                        const std::string&) {}
+  virtual void PushTypedMessage(LOG::TypeInfo, int, const char*, int,
+                                const std::string&) {}
+};
+
+void PrintThroughput(const char* title, double time) {
+  std::cout << title << ": " << kNumIterations / time << " messages/sec ("
+            << time * 1e9 / kNumIterations << " ns/message)" << std::endl;
+}
+
+template <typename Stream>
+std::size_t BuildMessage(Stream& stream, int i) {
+  stream << "request " << i << " done in " << i * 0.25 << " ms: " << "ok";
+  return stream.str().size();
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::size_t total_size = 0;
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      std::ostringstream stream;
+      total_size += BuildMessage(stream, i);
+    }
+    PrintThroughput("std::ostringstream", timer.GetTime());
+  }
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG::MessageStream stream;
+      stream << "request " << i << " done in " << i * 0.25 << " ms: " << "ok";
+      total_size += stream.size();
+    }
+    PrintThroughput("MessageStream", timer.GetTime());
+  }
+  {
+    NullLogger logger;
+    LOG::SetLogger(logger);
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG(INFO) << "request " << i << " done in " << i * 0.25 << " ms: "
+                << "ok";
+    }
+    PrintThroughput("LOG(INFO) to a null logger", timer.GetTime());
+    LOG::UseDefaultLogger();
+  }
+  return total_size == 0;
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "elog.h"
+#include "message_stream.h"
+
+namespace {
+
+volatile std::size_t allocation_count = 0;
+
+// Not inlined, so that the compiler does not pair malloc in operator new with
+// free in operator delete.
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void Deallocate(void* ptr) {
+  std::free(ptr);
+}
+
+}  // anonymous namespace
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) throw() {
+  Deallocate(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* ptr, std::size_t) throw() {
+  Deallocate(ptr);
+}
+#endif
+
+namespace LOG {
+
+namespace {
+
+struct Point {
+  int x;
+  int y;
+};
+
+std::ostream& operator<<(std::ostream& os, const Point& point) {
+  return os << '<' << point.x << ' ' << point.y << '>';
+}
+
+template <typename T>
+void VerifySameAsOstream(const T& t) {
+  std::ostringstream expected;
+  expected << t;
+  MessageStream stream;
+  stream << t;
+  EXPECT_EQ(expected.str(), stream.str());
+}
+
+// Logger which only remembers the last message.
+class LastMessageLogger : public Logger {
+ public:
+  LastMessageLogger()
+      : message_size_(0) {
+  }
+
+  const std::string& message() const {
+    return message_;
+  }
+
+  std::size_t message_size() const {
+    return message_size_;
+  }
+
+  virtual void PushRawMessage(LogLevel, const std::string& message) {
+    message_ = message;
+  }
+
+  virtual void PushMessage(LogLevel,
+                           const char*,
+                           int,
+                           const std::string& message) {
+    message_ = message;
+  }
+
+  virtual void PushMessage(LogLevel,
+                           const char*,
+                           int,
+                           const char*,
+                           std::size_t message_size) {
+    message_size_ = message_size;
+  }
+
+  virtual void PushFatalMessageAndThrow(const char*,
+                                        int,
+                                        const std::string&) {
+    throw FatalLogError();
+  }
+
+  virtual void PushCheckMessageAndThrow(const char*,
+                                        int,
+                                        const std::string&) {
+    throw CheckError();
+  }
+
+  virtual void PushTypedMessage(TypeInfo,
+                                int,
+                                const char*,
+                                int,
+                                const std::string& message) {
+    message_ = message;
+  }
+
+ private:
+  std::string message_;
+  std::size_t message_size_;
+};
+
+}  // anonymous namespace
+
+TEST(MessageStreamTest, Empty) {
+  MessageStream stream;
+  EXPECT_EQ(0u, stream.size());
+  EXPECT_EQ("", stream.str());
+}
+
+TEST(MessageStreamTest, SameAsOstream) {
+  VerifySameAsOstream('A');
+  VerifySameAsOstream("abc");
+  VerifySameAsOstream(std::string("abc"));
+  VerifySameAsOstream(true);
+  VerifySameAsOstream(static_cast<short>(-123));
+  VerifySameAsOstream(0);
+  VerifySameAsOstream(-2147483647 - 1);
+  VerifySameAsOstream(4294967295u);
+  VerifySameAsOstream(-9223372036854775807LL - 1);
+  VerifySameAsOstream(18446744073709551615ULL);
+  VerifySameAsOstream(0.1);
+  VerifySameAsOstream(1e100);
+  VerifySameAsOstream(-2.5f);
+  VerifySameAsOstream(0.1f);
+  VerifySameAsOstream(-0.0);
+  VerifySameAsOstream(1234567.0);
+  VerifySameAsOstream(1.0 / 3);
+  VerifySameAsOstream(5e-324);
+  const int value = 0;
+  VerifySameAsOstream(static_cast<const void*>(&value));
+  VerifySameAsOstream(static_cast<const void*>(NULL));
+}
+
+TEST(MessageStreamTest, NullString) {
+  MessageStream stream;
+  const char* s = NULL;
+  stream << s << " and " << std::hex << s << ' ' << 255;
+  EXPECT_EQ("(null) and (null) ff", stream.str());
+}
+
+TEST(MessageStreamTest, UserDefinedType) {
+  Point point = { 1, 2 };
+  VerifySameAsOstream(point);
+}
+
+TEST(MessageStreamTest, Manipulators) {
+  MessageStream stream;
+  stream << std::hex << 255 << ' ' << std::setw(4) << std::setfill('0') << 7
+         << std::dec << ' ' << 10;
+  EXPECT_EQ("ff 0007 10", stream.str());
+}
+
+TEST(MessageStreamTest, LongMessage) {
+  const std::string chunk(1000, 'x');
+  std::string expected;
+  MessageStream stream;
+  for (int i = 0; i < 10; ++i) {
+    stream << chunk << i;
+    expected += chunk;
+    expected += static_cast<char>('0' + i);
+  }
+  EXPECT_EQ(expected, stream.str());
+}
+
+TEST(MessageStreamTest, NestedStreams) {
+  MessageStream outer;
+  outer << "outer";
+  {
+    MessageStream inner;
+    inner << "inner";
+    EXPECT_EQ("inner", inner.str());
+  }
+  outer << " message";
+  EXPECT_EQ("outer message", outer.str());
+}
+
+TEST(MessageStreamTest, GivenBuffer) {
+  char buffer[8];
+  const std::size_t initial_allocation_count = allocation_count;
+  MessageStream stream(buffer, sizeof(buffer));
+  stream << "abc" << 123;
+  EXPECT_EQ(initial_allocation_count, allocation_count);
+  EXPECT_EQ(buffer, stream.data());
+
+  stream << "defgh";  // spills to the heap
+  EXPECT_EQ("abc123defgh", stream.str());
+  EXPECT_NE(buffer, stream.data());
+}
+
+TEST(MessageStreamTest, LogWithoutAllocation) {
+  LastMessageLogger logger;
+  SetLogger(logger);
+  LOG() << "warm up";
+
+  const std::string value = "value";
+  const std::size_t initial_allocation_count = allocation_count;
+  LOG() << value << ": " << 12345 << ", " << 0.5 << ", " << 'c';
+  EXPECT_EQ(initial_allocation_count, allocation_count);
+  EXPECT_EQ(sizeof("value: 12345, 0.5, c") - 1, logger.message_size());
+
+  UseDefaultLogger();
+}
+
+}  // namespace LOG
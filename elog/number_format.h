@@ -0,0 +1,327 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_NUMBER_FORMAT_H_
+#define ELOG_NUMBER_FORMAT_H_
+
+#include <cstddef>
+#include <cstring>
+
+namespace LOG {
+
+static const std::size_t kMaxUnsignedDigits = 20;
+static const std::size_t kMaxGeneralDoubleSize = 16;
+
+// Writes the decimal digits of n ending at end, two digits at a time, and
+// returns the beginning. The buffer needs kMaxUnsignedDigits characters.
+inline char* FormatUnsigned(unsigned long long n, char* end) {
+  static const char kDigitPairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233"
+      "34353637383940414243444546474849505152535455565758596061626364656667"
+      "6869707172737475767778798081828384858687888990919293949596979899";
+  char* begin = end;
+  while (n >= 100) {
+    const std::size_t index = static_cast<std::size_t>(n % 100) * 2;
+    n /= 100;
+    *--begin = kDigitPairs[index + 1];
+    *--begin = kDigitPairs[index];
+  }
+  if (n >= 10) {
+    const std::size_t index = static_cast<std::size_t>(n) * 2;
+    *--begin = kDigitPairs[index + 1];
+    *--begin = kDigitPairs[index];
+  } else {
+    *--begin = static_cast<char>('0' + n);
+  }
+  return begin;
+}
+
+// Floating-point number of 64 bits of significand, used by Grisu2.
+struct DiyFp {
+  static const int kSignificandSize = 52;
+  static const unsigned long long kHiddenBit = 1ULL << kSignificandSize;
+
+  DiyFp(unsigned long long significand, int exponent)
+      : f(significand),
+        e(exponent) {
+  }
+
+  // The value must be positive and finite.
+  explicit DiyFp(double value) {
+    unsigned long long bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const int biased_exponent = static_cast<int>(bits >> kSignificandSize);
+    const unsigned long long significand = bits & (kHiddenBit - 1);
+    if (biased_exponent) {
+      f = significand + kHiddenBit;
+      e = biased_exponent - 1075;
+    } else {
+      f = significand;
+      e = -1074;
+    }
+  }
+
+  DiyFp operator-(const DiyFp& rhs) const {
+    return DiyFp(f - rhs.f, e);
+  }
+
+  // Rounded product of the upper 64 bits.
+  DiyFp operator*(const DiyFp& rhs) const {
+    const unsigned long long kMask32 = 0xffffffffULL;
+    const unsigned long long a = f >> 32, b = f & kMask32;
+    const unsigned long long c = rhs.f >> 32, d = rhs.f & kMask32;
+    const unsigned long long ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    unsigned long long middle = (bd >> 32) + (ad & kMask32) + (bc & kMask32);
+    middle += 1ULL << 31;
+    return DiyFp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32),
+                 e + rhs.e + 64);
+  }
+
+  DiyFp Normalize() const {
+    DiyFp result = *this;
+    while (!(result.f & (1ULL << 63))) {
+      result.f <<= 1;
+      --result.e;
+    }
+    return result;
+  }
+
+  // Boundaries of the values rounded to this, with the same exponent.
+  void GetNormalizedBoundaries(DiyFp& minus, DiyFp& plus) const {
+    plus = DiyFp((f << 1) + 1, e - 1).Normalize();
+    minus = f == kHiddenBit ?
+        DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+  }
+
+  unsigned long long f;
+  int e;
+};
+
+// Normalized 10^k for k = -348, -340, ..., 340, and the largest k such that
+// the binary exponent of the product with a significand of exponent e is at
+// most -61.
+inline DiyFp GetCachedPower(int e, int& k) {
+  static const unsigned long long kSignificands[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+  };
+  static const short kExponents[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+  };
+  const double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int power = static_cast<int>(dk);
+  if (dk - power > 0.0) ++power;
+  const std::size_t index = static_cast<std::size_t>((power >> 3) + 1);
+  k = -(-348 + static_cast<int>(index) * 8);
+  return DiyFp(kSignificands[index], kExponents[index]);
+}
+
+inline const unsigned long long* GetPowersOfTen() {
+  static const unsigned long long kPowersOfTen[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL
+  };
+  return kPowersOfTen;
+}
+
+// Moves the last digit towards the value while it stays in the boundaries.
+inline void GrisuRound(char* digits,
+                       int size,
+                       unsigned long long delta,
+                       unsigned long long rest,
+                       unsigned long long ten_kappa,
+                       unsigned long long distance) {
+  while (rest < distance && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < distance ||
+          distance - rest > rest + ten_kappa - distance)) {
+    --digits[size - 1];
+    rest += ten_kappa;
+  }
+}
+
+inline void GenerateGrisuDigits(const DiyFp& w,
+                                const DiyFp& upper,
+                                unsigned long long delta,
+                                char* digits,
+                                int& size,
+                                int& k) {
+  const unsigned long long* const kPowersOfTen = GetPowersOfTen();
+  const DiyFp one(1ULL << -upper.e, upper.e);
+  const DiyFp distance = upper - w;
+  unsigned int integral = static_cast<unsigned int>(upper.f >> -one.e);
+  unsigned long long fractional = upper.f & (one.f - 1);
+
+  int kappa = 1;
+  while (kappa < 10 && integral >= kPowersOfTen[kappa]) {
+    ++kappa;
+  }
+  size = 0;
+  while (kappa > 0) {
+    const unsigned long long power = kPowersOfTen[kappa - 1];
+    const unsigned int digit = static_cast<unsigned int>(integral / power);
+    integral = static_cast<unsigned int>(integral % power);
+    if (digit || size) {
+      digits[size++] = static_cast<char>('0' + digit);
+    }
+    --kappa;
+    const unsigned long long rest =
+        (static_cast<unsigned long long>(integral) << -one.e) + fractional;
+    if (rest <= delta) {
+      k += kappa;
+      GrisuRound(digits, size, delta, rest, kPowersOfTen[kappa] << -one.e,
+                 distance.f);
+      return;
+    }
+  }
+  for (;;) {
+    fractional *= 10;
+    delta *= 10;
+    const char digit = static_cast<char>(fractional >> -one.e);
+    if (digit || size) {
+      digits[size++] = static_cast<char>('0' + digit);
+    }
+    fractional &= one.f - 1;
+    --kappa;
+    if (fractional < delta) {
+      k += kappa;
+      GrisuRound(digits, size, delta, fractional, one.f,
+                 -kappa < 20 ? distance.f * kPowersOfTen[-kappa] : 0);
+      return;
+    }
+  }
+}
+
+// Writes the digits of the positive finite value by Grisu2, and returns the
+// number of them; the value is read back from the digits times 10^exponent.
+// The digits are the shortest ones for about 99.9% of values, and at most 17.
+inline int FormatShortestDigits(double value, char* digits, int& exponent) {
+  const DiyFp v(value);
+  DiyFp minus(0, 0), plus(0, 0);
+  v.GetNormalizedBoundaries(minus, plus);
+
+  const DiyFp cached_power = GetCachedPower(plus.e, exponent);
+  const DiyFp w = v.Normalize() * cached_power;
+  DiyFp upper = plus * cached_power;
+  DiyFp lower = minus * cached_power;
+  ++lower.f;
+  --upper.f;
+  int size;
+  GenerateGrisuDigits(w, upper, upper.f - lower.f, digits, size, exponent);
+  while (size > 1 && digits[size - 1] == '0') {
+    --size;
+    ++exponent;
+  }
+  return size;
+}
+
+// Writes the value as printf("%g") does, if it is zero or normal and its
+// shortest digits are at most the precision of %g, 6, and returns the size.
+// Such digits round-trip, so they are what printf rounds the value to. Returns
+// zero for other values, which printf must format. The buffer needs
+// kMaxGeneralDoubleSize characters.
+inline std::size_t FormatGeneralDouble(double value, char* buffer) {
+  static const int kPrecision = 6;
+
+  unsigned long long bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  char* p = buffer;
+  if (bits >> 63) {
+    *p++ = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    *p++ = '0';
+    return p - buffer;
+  }
+  // Subnormal values are not precise enough to be rounded as the digits.
+  if (!(value >= 2.2250738585072014e-308 && value <= 1.7976931348623157e308)) {
+    return 0;
+  }
+
+  char digits[20];
+  int exponent;
+  const int size = FormatShortestDigits(value, digits, exponent);
+  if (size > kPrecision) return 0;
+
+  // Exponent of the first digit.
+  const int point = exponent + size - 1;
+  if (point < -4 || point >= kPrecision) {
+    *p++ = digits[0];
+    if (size > 1) {
+      *p++ = '.';
+      std::memcpy(p, digits + 1, size - 1);
+      p += size - 1;
+    }
+    *p++ = 'e';
+    *p++ = point < 0 ? '-' : '+';
+    const int magnitude = point < 0 ? -point : point;
+    if (magnitude >= 100) {
+      *p++ = static_cast<char>('0' + magnitude / 100);
+    }
+    *p++ = static_cast<char>('0' + magnitude / 10 % 10);
+    *p++ = static_cast<char>('0' + magnitude % 10);
+  } else if (point >= 0) {
+    for (int i = 0; i <= point; ++i) {
+      *p++ = i < size ? digits[i] : '0';
+    }
+    if (size > point + 1) {
+      *p++ = '.';
+      std::memcpy(p, digits + point + 1, size - point - 1);
+      p += size - point - 1;
+    }
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > point; --i) {
+      *p++ = '0';
+    }
+    std::memcpy(p, digits, size);
+    p += size;
+  }
+  return p - buffer;
+}
+
+}  // namespace LOG
+
+#endif  // ELOG_NUMBER_FORMAT_H_
@@ -0,0 +1,119 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "number_format.h"
+
+namespace LOG {
+
+namespace {
+
+std::string FormatUnsignedToString(unsigned long long n) {
+  char digits[kMaxUnsignedDigits];
+  char* const end = digits + sizeof(digits);
+  const char* const begin = FormatUnsigned(n, end);
+  return std::string(begin, static_cast<const char*>(end));
+}
+
+std::string Printf(const char* format, double value) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), format, value);
+  return buffer;
+}
+
+// Returns an empty string if printf is needed.
+std::string FormatGeneralDoubleToString(double value) {
+  char buffer[kMaxGeneralDoubleSize];
+  return std::string(buffer, FormatGeneralDouble(value, buffer));
+}
+
+double GetRandomDouble() {
+  unsigned long long bits = 0;
+  for (int i = 0; i < 4; ++i) {
+    bits = bits << 16 | (std::rand() & 0xffff);
+  }
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // anonymous namespace
+
+TEST(NumberFormatTest, Unsigned) {
+  unsigned long long n = 1;
+  for (int i = 0; i < 20; ++i) {
+    std::ostringstream expected;
+    expected << n - 1 << ' ' << n << ' ' << n + 1;
+    EXPECT_EQ(expected.str(), FormatUnsignedToString(n - 1) + ' ' +
+              FormatUnsignedToString(n) + ' ' + FormatUnsignedToString(n + 1));
+    n *= 10;
+  }
+  EXPECT_EQ("18446744073709551615",
+            FormatUnsignedToString(18446744073709551615ULL));
+}
+
+TEST(NumberFormatTest, ShortestDigitsRoundTrip) {
+  std::srand(1);
+  for (int i = 0; i < 100000; ++i) {
+    const double value = std::abs(GetRandomDouble());
+    if (!(value > 0 && value <= 1.7976931348623157e308)) continue;
+    char digits[32];
+    int exponent;
+    const int size = FormatShortestDigits(value, digits, exponent);
+    ASSERT_GE(17, size);
+    std::sprintf(digits + size, "e%d", exponent);
+    ASSERT_EQ(value, std::strtod(digits, NULL)) << digits;
+  }
+}
+
+TEST(NumberFormatTest, ShortestDigits) {
+  char digits[32];
+  int exponent;
+  ASSERT_EQ(1, FormatShortestDigits(0.1, digits, exponent));
+  EXPECT_EQ('1', digits[0]);
+  EXPECT_EQ(-1, exponent);
+  ASSERT_EQ(3, FormatShortestDigits(1.25e300, digits, exponent));
+  EXPECT_EQ("125", std::string(digits, 3));
+  EXPECT_EQ(298, exponent);
+  ASSERT_EQ(1, FormatShortestDigits(5e-324, digits, exponent));
+  EXPECT_EQ('5', digits[0]);
+  EXPECT_EQ(-324, exponent);
+}
+
+TEST(NumberFormatTest, GeneralDouble) {
+  const double kValues[] = {
+    0.0, -0.0, 1.0, -2.5, 0.1, 0.5, 1e-4, 1e-5, 1.5e-5, 123456.0, 100000.0,
+    1e6, 1e100, -1e-100, 2.5e-308, 1.5e308
+  };
+  for (std::size_t i = 0; i < sizeof(kValues) / sizeof(kValues[0]); ++i) {
+    EXPECT_EQ(Printf("%g", kValues[i]),
+              FormatGeneralDoubleToString(kValues[i]));
+  }
+}
+
+TEST(NumberFormatTest, GeneralDoubleFallsBackToPrintf) {
+  EXPECT_EQ("", FormatGeneralDoubleToString(1234567.0));
+  EXPECT_EQ("", FormatGeneralDoubleToString(1.0 / 3));
+  EXPECT_EQ("", FormatGeneralDoubleToString(5e-324));
+  EXPECT_EQ("", FormatGeneralDoubleToString(1e308 * 10));
+}
+
+TEST(NumberFormatTest, GeneralDoubleSameAsPrintf) {
+  std::srand(2);
+  for (int i = 0; i < 100000; ++i) {
+    const double value = i % 2 ?
+        GetRandomDouble() : (std::rand() % 2000001 - 1000000) * 1e-3;
+    const std::string formatted = FormatGeneralDoubleToString(value);
+    if (!formatted.empty()) {
+      ASSERT_EQ(Printf("%g", value), formatted) << Printf("%.17g", value);
+    }
+  }
+}
+
+}  // namespace LOG
@@ -0,0 +1,183 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_PERF_COUNTERS_H_
+#define ELOG_PERF_COUNTERS_H_
+
+#include "config.h"
+
+#ifdef __linux__
+# define ELOG_I_HAS_PERF_EVENT
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include <cstring>
+#endif
+
+#include <cstddef>
+#include "util.h"
+
+namespace LOG {
+
+enum PerfCounter {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_CONTEXT_SWITCHES
+};
+
+static const std::size_t kNumPerfCounters = 5;
+
+inline const char* GetPerfCounterName(std::size_t counter) {
+  static const char* const kNames[kNumPerfCounters] = {
+    "cycles", "instructions", "cache misses", "branch misses",
+    "context switches"
+  };
+  return kNames[counter];
+}
+
+static const long long kPerfCounterUnavailable = -1;
+
+// Counts of the events, or kPerfCounterUnavailable for the counters not
+// opened.
+struct PerfCounterValues {
+  long long values[kNumPerfCounters];
+};
+
+// Writes the available counters like "cycles: 123, instructions: 456".
+template <typename Stream>
+inline void PrintPerfCounterValues(const PerfCounterValues& values,
+                                   Stream& os) {
+  bool first = true;
+  for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+    if (values.values[i] == kPerfCounterUnavailable) continue;
+    os << (first ? "" : ", ") << GetPerfCounterName(i) << ": "
+       << values.values[i];
+    first = false;
+  }
+}
+
+template <AvoidODR>
+struct PerfCounterFlagTemplate {
+  static volatile bool enabled;
+};
+
+template <AvoidODR N>
+volatile bool PerfCounterFlagTemplate<N>::enabled;
+
+typedef PerfCounterFlagTemplate<AVOID_ODR> PerfCounterFlag;
+
+// Makes BENCHMARK scopes started after the call count the events of their
+// thread by the perf_event_open system call of Linux, and report the deltas
+// with the time. Opening the counters takes some microseconds per scope, out
+// of the measured time. Counters which cannot be opened, e.g. for lack of the
+// permission, are not reported; on other systems, no counters are available.
+inline void EnablePerfCounters(bool enabled = true) {
+  PerfCounterFlag::enabled = enabled;
+}
+
+inline bool IsPerfCountersEnabled() {
+  return PerfCounterFlag::enabled;
+}
+
+// Hardware and software event counters of the calling thread, counting from
+// the construction.
+class PerfCounters : Noncopyable {
+ public:
+  PerfCounters() {
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      files_[i] = Open(static_cast<PerfCounter>(i));
+    }
+    Read(start_values_);
+  }
+
+  ~PerfCounters() {
+#ifdef ELOG_I_HAS_PERF_EVENT
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      if (files_[i] >= 0) close(files_[i]);
+    }
+#endif
+  }
+
+  bool IsAvailable() const {
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      if (files_[i] >= 0) return true;
+    }
+    return false;
+  }
+
+  // Counts since the construction.
+  void GetDeltas(PerfCounterValues& deltas) const {
+    Read(deltas);
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      if (deltas.values[i] == kPerfCounterUnavailable) continue;
+      deltas.values[i] -= start_values_.values[i];
+    }
+  }
+
+ private:
+  void Read(PerfCounterValues& values) const {
+    for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+      values.values[i] = kPerfCounterUnavailable;
+#ifdef ELOG_I_HAS_PERF_EVENT
+      long long value;
+      if (files_[i] >= 0 &&
+          read(files_[i], &value, sizeof(value)) == sizeof(value)) {
+        values.values[i] = value;
+      }
+#endif
+    }
+  }
+
+  // Returns -1 on failure.
+  static int Open(PerfCounter counter) {
+#ifdef ELOG_I_HAS_PERF_EVENT
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    switch (counter) {
+      case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case PERF_CACHE_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+      case PERF_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+      case PERF_CONTEXT_SWITCHES:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+        break;
+    }
+    attr.exclude_hv = 1;
+    // Counting the kernel may not be permitted; then count the user only.
+    int file = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                        0));
+    if (file < 0) {
+      attr.exclude_kernel = 1;
+      file = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                      0));
+    }
+    return file;
+#else
+    (void) counter;
+    return -1;
+#endif
+  }
+
+  int files_[kNumPerfCounters];
+  PerfCounterValues start_values_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_PERF_COUNTERS_H_
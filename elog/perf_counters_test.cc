@@ -0,0 +1,82 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "benchmark.h"
+#include "benchmark_suite.h"
+#include "logger_factory.h"
+#include "perf_counters.h"
+
+namespace LOG {
+
+namespace {
+
+TEST(PerfCountersTest, DeltasAreNotNegative) {
+  PerfCounters perf_counters;
+  volatile int sum = 0;
+  for (int i = 0; i < 100000; ++i) {
+    sum += i;
+  }
+  PerfCounterValues deltas;
+  perf_counters.GetDeltas(deltas);
+  for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+    EXPECT_LE(kPerfCounterUnavailable, deltas.values[i]);
+  }
+  if (deltas.values[PERF_INSTRUCTIONS] != kPerfCounterUnavailable) {
+    EXPECT_LT(100000, deltas.values[PERF_INSTRUCTIONS]);
+  }
+}
+
+TEST(PerfCountersTest, PrintAvailableValues) {
+  PerfCounterValues values = { { -1, 200, -1, 3, 0 } };
+  std::ostringstream stream;
+  PrintPerfCounterValues(values, stream);
+  EXPECT_EQ("instructions: 200, branch misses: 3, context switches: 0",
+            stream.str());
+}
+
+TEST(PerfCountersTest, ChartShowsMeansOfUsedCounters) {
+  BenchmarkSuite suite("suite");
+  PerfCounterValues values = { { -1, 100, -1, -1, -1 } };
+  suite.AddSample(suite.GetCaseId("counted"), 1.0, 1, &values);
+  values.values[PERF_INSTRUCTIONS] = 300;
+  suite.AddSample(suite.GetCaseId("counted"), 1.0, 1, &values);
+  suite.AddCase("uncounted", 1.0);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  EXPECT_EQ(400, chart[0].perf_counter_sums[PERF_INSTRUCTIONS]);
+  EXPECT_EQ(2, chart[0].perf_counter_runs[PERF_INSTRUCTIONS]);
+  EXPECT_EQ(0, chart[0].perf_counter_runs[PERF_CYCLES]);
+
+  const std::string printed = suite.PrintChart();
+  EXPECT_NE(std::string::npos, printed.find("| instructions\n"));
+  EXPECT_EQ(std::string::npos, printed.find("cycles"));
+  EXPECT_NE(std::string::npos, printed.find("|          200\n"));
+  EXPECT_NE(std::string::npos, printed.find("|            -\n"));
+}
+
+TEST(PerfCountersTest, ScopesFallBackToTime) {
+  SetDefaultLoggerLevel(WARN);
+  BenchmarkSuite suite("suite");
+  EnablePerfCounters();
+  BENCHMARK(suite, counted) {
+  }
+  EnablePerfCounters(false);
+  BENCHMARK(suite, counted) {
+  }
+  SetDefaultLoggerLevel(INFO);
+
+  const BenchmarkSuite::Chart chart = suite.GetChart();
+  ASSERT_EQ(1u, chart.size());
+  EXPECT_EQ(2, chart[0].histogram.count());
+  const bool available = PerfCounters().IsAvailable();
+  for (std::size_t i = 0; i < kNumPerfCounters; ++i) {
+    EXPECT_GE(available ? 1 : 0, chart[0].perf_counter_runs[i]);
+  }
+}
+
+}  // namespace
+
+}  // namespace LOG
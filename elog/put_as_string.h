@@ -5,6 +5,8 @@
 #define ELOG_PUT_AS_STRING_H_
 
 #include <cstddef>
+#include <cstring>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -13,6 +15,214 @@
 
 namespace LOG {
 
+template <typename T, typename Stream>
+void PutAsString(const T& t, Stream& stream);
+
+// Limits of writing strings, pairs and containers, which bound the time and
+// the memory of logging large ones. Zero means no limit.
+struct PrintLimits {
+  std::size_t max_elements;  // of each container
+  std::size_t max_depth;  // of nested pairs and containers
+  std::size_t max_bytes;  // of each argument, with what is nested in it
+};
+
+template <AvoidODR>
+struct PrintLimitsTemplate {
+  static volatile std::size_t max_elements;
+  static volatile std::size_t max_depth;
+  static volatile std::size_t max_bytes;
+};
+
+template <AvoidODR N>
+volatile std::size_t PrintLimitsTemplate<N>::max_elements;
+
+template <AvoidODR N>
+volatile std::size_t PrintLimitsTemplate<N>::max_depth;
+
+template <AvoidODR N>
+volatile std::size_t PrintLimitsTemplate<N>::max_bytes;
+
+typedef PrintLimitsTemplate<AVOID_ODR> DefaultPrintLimits;
+
+// Manipulator which sets the limits for the rest of the log statement:
+//
+//   LOG() << LOG::LimitPrinting(100) << huge_vector;
+//
+// The limits are also given to SetPrintLimits().
+inline PrintLimits LimitPrinting(std::size_t max_elements,
+                                 std::size_t max_depth = 0,
+                                 std::size_t max_bytes = 0) {
+  PrintLimits limits = { max_elements, max_depth, max_bytes };
+  return limits;
+}
+
+// Sets the limits with which log statements start. Nothing is limited by
+// default.
+inline void SetPrintLimits(const PrintLimits& limits) {
+  DefaultPrintLimits::max_elements = limits.max_elements;
+  DefaultPrintLimits::max_depth = limits.max_depth;
+  DefaultPrintLimits::max_bytes = limits.max_bytes;
+}
+
+inline PrintLimits GetPrintLimits() {
+  return LimitPrinting(DefaultPrintLimits::max_elements,
+                       DefaultPrintLimits::max_depth,
+                       DefaultPrintLimits::max_bytes);
+}
+
+// Limits of a stream and the pair or container being written.
+struct PrintState {
+  PrintState()
+      : limits(GetPrintLimits()),
+        depth(0),
+        begin(0) {
+  }
+
+  PrintLimits limits;
+  std::size_t depth;
+  std::size_t begin;  // size of the stream before the outermost one
+};
+
+// Streams which have a PrintState overload these two hooks; for other
+// streams, nothing is limited and LimitPrinting() is ignored.
+template <typename Stream>
+inline PrintState* GetPrintState(Stream&) {
+  return NULL;
+}
+
+template <typename Stream>
+inline std::size_t GetPrintedSize(const Stream&) {
+  return 0;
+}
+
+// Hooks called around the elements of pairs and containers. They write the
+// text notation by default; streams with another notation overload them.
+template <typename Stream>
+inline void PutPairBegin(Stream& stream) {
+  stream << '(';
+}
+
+template <typename Stream>
+inline void PutPairSeparator(Stream& stream) {
+  stream << ',';
+}
+
+template <typename Stream>
+inline void PutPairEnd(Stream& stream) {
+  stream << ')';
+}
+
+template <typename Stream>
+inline void PutSequenceBegin(Stream&) {
+}
+
+template <typename Stream>
+inline void PutSequenceSeparator(Stream& stream) {
+  stream << ',';
+}
+
+template <typename Stream>
+inline void PutSequenceEnd(Stream&) {
+}
+
+// Written in place of the elements omitted by the limits, after the
+// separator.
+template <typename Stream>
+inline void PutSequenceOmission(std::size_t num_omitted, Stream& stream) {
+  stream << "...(" << num_omitted << " more)";
+}
+
+// Written in place of pairs and containers nested deeper than the limit.
+template <typename Stream>
+inline void PutNestingOmission(Stream& stream) {
+  stream << "...";
+}
+
+// Returns the number of bytes which the max_bytes limit leaves to the value
+// written next, or the max of size_t if it is not limited.
+template <typename Stream>
+inline std::size_t GetBytesLeftToPrint(Stream& stream) {
+  const PrintState* state = GetPrintState(stream);
+  if (!state || state->limits.max_bytes == 0) {
+    return static_cast<std::size_t>(-1);
+  }
+  const std::size_t max_bytes = state->limits.max_bytes;
+  if (state->depth == 0) return max_bytes;
+  const std::size_t printed = GetPrintedSize(stream) - state->begin;
+  return printed < max_bytes ? max_bytes - printed : 0;
+}
+
+// Writes the first bytes of the string followed by the omission of the rest.
+template <typename Stream>
+inline void PutTruncatedString(const char* s,
+                               std::size_t size,
+                               std::size_t bytes,
+                               Stream& stream) {
+  stream.write(s, bytes);
+  PutSequenceOmission(size - bytes, stream);
+}
+
+// Counts the depth of nested pairs and containers while one is written.
+// Enter() returns false if it is too deep to be written.
+template <typename Stream>
+class PrintDepthScope : Noncopyable {
+ public:
+  explicit PrintDepthScope(Stream& stream)
+      : stream_(stream),
+        state_(GetPrintState(stream)) {
+  }
+
+  ~PrintDepthScope() {
+    if (state_) --state_->depth;
+  }
+
+  bool Enter() {
+    if (!state_) return true;
+    const std::size_t max_depth = state_->limits.max_depth;
+    if (max_depth != 0 && state_->depth >= max_depth) {
+      state_ = NULL;
+      return false;
+    }
+    if (state_->depth++ == 0) {
+      state_->begin = GetPrintedSize(stream_);
+    }
+    return true;
+  }
+
+  // Returns whether the elements from the index on should be omitted.
+  bool IsExhausted(std::size_t index) const {
+    if (!state_) return false;
+    const PrintLimits& limits = state_->limits;
+    return (limits.max_elements != 0 && index >= limits.max_elements) ||
+        (limits.max_bytes != 0 &&
+         GetPrintedSize(stream_) - state_->begin >= limits.max_bytes);
+  }
+
+ private:
+  Stream& stream_;
+  PrintState* state_;
+};
+
+// Counts the elements from the index-th one at itr to the end, in constant
+// time if the container has size().
+template <typename Container, bool HasSize = HasSize<Container>::value>
+struct RestCountFunction {
+  std::size_t operator()(const Container& container,
+                         typename Container::const_iterator itr,
+                         std::size_t) const {
+    return std::distance(itr, container.end());
+  }
+};
+
+template <typename Container>
+struct RestCountFunction<Container, true> {
+  std::size_t operator()(const Container& container,
+                         typename Container::const_iterator,
+                         std::size_t index) const {
+    return container.size() - index;
+  }
+};
+
 template <typename T, bool IsContainer = IsContainer<T>::value>
 struct StringBuildFunction {
   template <typename Stream>
@@ -25,11 +235,16 @@ template <typename S, typename T>
 struct StringBuildFunction<std::pair<S, T>, false> {
   template <typename Stream>
   void operator()(const std::pair<S, T>& t, Stream& stream) const {
-    stream << '(';
+    PrintDepthScope<Stream> scope(stream);
+    if (!scope.Enter()) {
+      PutNestingOmission(stream);
+      return;
+    }
+    PutPairBegin(stream);
     PutAsString(t.first, stream);
-    stream << ',';
+    PutPairSeparator(stream);
     PutAsString(t.second, stream);
-    stream << ')';
+    PutPairEnd(stream);
   }
 };
 
@@ -38,13 +253,26 @@ struct StringBuildFunction<Container, true> {
   template <typename Stream>
   void operator()(const Container& container, Stream& stream) const {
     typedef typename Container::const_iterator Iterator;
+    PrintDepthScope<Stream> scope(stream);
+    if (!scope.Enter()) {
+      PutNestingOmission(stream);
+      return;
+    }
     Iterator begin = container.begin();
-    for (Iterator itr = container.begin(); itr != container.end(); ++itr) {
+    PutSequenceBegin(stream);
+    std::size_t index = 0;
+    for (Iterator itr = begin; itr != container.end(); ++itr, ++index) {
       if (itr != begin) {
-        stream << ',';
+        PutSequenceSeparator(stream);
+      }
+      if (scope.IsExhausted(index)) {
+        PutSequenceOmission(
+            RestCountFunction<Container>()(container, itr, index), stream);
+        break;
       }
       PutAsString(*itr, stream);
     }
+    PutSequenceEnd(stream);
   }
 };
 
@@ -52,7 +280,49 @@ template <>
 struct StringBuildFunction<std::string, true> {
   template <typename Stream>
   void operator()(const std::string& string, Stream& stream) const {
-    stream << string;
+    const std::size_t bytes = GetBytesLeftToPrint(stream);
+    if (string.size() <= bytes) {
+      stream << string;
+    } else {
+      PutTruncatedString(string.data(), string.size(), bytes, stream);
+    }
+  }
+};
+
+// The length is not counted unless max_bytes is set.
+template <>
+struct StringBuildFunction<const char*, false> {
+  template <typename Stream>
+  void operator()(const char* s, Stream& stream) const {
+    const std::size_t bytes = GetBytesLeftToPrint(stream);
+    const std::size_t size =
+        s && bytes != static_cast<std::size_t>(-1) ? std::strlen(s) : 0;
+    if (size <= bytes) {
+      stream << s;
+    } else {
+      PutTruncatedString(s, size, bytes, stream);
+    }
+  }
+};
+
+template <>
+struct StringBuildFunction<char*, false>
+    : StringBuildFunction<const char*, false> {
+};
+
+template <std::size_t N>
+struct StringBuildFunction<char[N], false>
+    : StringBuildFunction<const char*, false> {
+};
+
+// Writes nothing.
+template <>
+struct StringBuildFunction<PrintLimits, false> {
+  template <typename Stream>
+  void operator()(const PrintLimits& limits, Stream& stream) const {
+    if (PrintState* state = GetPrintState(stream)) {
+      state->limits = limits;
+    }
   }
 };
 
@@ -0,0 +1,86 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures PutAsString() of integers and doubles into std::ostringstream and
+// into MessageStream, which formats them without iostreams.
+
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include "message_stream.h"
+#include "put_as_string.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+const int kNumValuesPerMessage = 8;
+
+void PrintThroughput(const char* title, double time) {
+  const double num_values =
+      static_cast<double>(kNumIterations) * kNumValuesPerMessage;
+  std::cout << title << ": " << num_values / time << " values/sec ("
+            << time * 1e9 / num_values << " ns/value)" << std::endl;
+}
+
+template <typename Stream>
+void PutIntegers(int i, Stream& stream) {
+  for (int j = 0; j < kNumValuesPerMessage; ++j) {
+    LOG::PutAsString(i * 2654435761LL + j, stream);
+    stream << ' ';
+  }
+}
+
+template <typename Stream>
+void PutShortDoubles(int i, Stream& stream) {
+  for (int j = 0; j < kNumValuesPerMessage; ++j) {
+    LOG::PutAsString((i % 1000 + j) * 0.25, stream);
+    stream << ' ';
+  }
+}
+
+template <typename Stream>
+void PutLongDoubles(int i, Stream& stream) {
+  for (int j = 0; j < kNumValuesPerMessage; ++j) {
+    LOG::PutAsString((i + j) / 3.0, stream);
+    stream << ' ';
+  }
+}
+
+template <void (*Put)(int, std::ostringstream&),
+          void (*PutToMessageStream)(int, LOG::MessageStream&)>
+std::size_t Measure(const char* title) {
+  std::size_t total_size = 0;
+  std::cout << title << std::endl;
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      std::ostringstream stream;
+      Put(i, stream);
+      total_size += stream.str().size();
+    }
+    PrintThroughput("  std::ostringstream", timer.GetTime());
+  }
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG::MessageStream stream;
+      PutToMessageStream(i, stream);
+      total_size += stream.size();
+    }
+    PrintThroughput("  MessageStream", timer.GetTime());
+  }
+  return total_size;
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::size_t total_size = 0;
+  total_size += Measure<PutIntegers, PutIntegers>("integers");
+  total_size += Measure<PutShortDoubles, PutShortDoubles>(
+      "doubles of at most 6 digits");
+  total_size += Measure<PutLongDoubles, PutLongDoubles>(
+      "doubles of more digits (printf)");
+  return total_size == 0;
+}
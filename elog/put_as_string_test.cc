@@ -5,7 +5,9 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 #include <gtest/gtest.h>
+#include "message_stream.h"
 #include "put_as_string.h"
 
 namespace LOG {
@@ -19,6 +21,46 @@ void VerifyStringOfValue(const T& t, const std::string& string) {
   EXPECT_EQ(string, stream.str());
 }
 
+template <typename T>
+std::string GetLimitedString(const T& t, const PrintLimits& limits) {
+  MessageStream stream;
+  PutAsString(limits, stream);
+  PutAsString(t, stream);
+  return stream.str();
+}
+
+// Container without size(), as std::forward_list.
+class SizelessSequence {
+ public:
+  typedef int value_type;
+  typedef const int* const_iterator;
+
+  SizelessSequence(const int* begin, const int* end)
+      : begin_(begin),
+        end_(end) {
+  }
+
+  const_iterator begin() const {
+    return begin_;
+  }
+
+  const_iterator end() const {
+    return end_;
+  }
+
+ private:
+  const int* begin_;
+  const int* end_;
+};
+
+std::vector<int> MakeSequence(int size) {
+  std::vector<int> sequence;
+  for (int i = 0; i < size; ++i) {
+    sequence.push_back(i);
+  }
+  return sequence;
+}
+
 }  // anonymous namespace
 
 TEST(StringBuilderTest, SingleConstCharPtr) {
@@ -93,4 +135,95 @@ TEST(StringBuilderTest, SingleSet) {
   VerifyStringOfValue(set, "abc,def,ghi");
 }
 
+TEST(StringBuilderTest, LimitElements) {
+  const std::vector<int> sequence = MakeSequence(10);
+  EXPECT_EQ("0,1,2,...(7 more)",
+            GetLimitedString(sequence, LimitPrinting(3)));
+  EXPECT_EQ("0,1,2,3,4,5,6,7,8,9",
+            GetLimitedString(sequence, LimitPrinting(10)));
+  EXPECT_EQ("0,1,2,3,4,5,6,7,8,9",
+            GetLimitedString(sequence, LimitPrinting(0)));
+}
+
+TEST(StringBuilderTest, LimitDepth) {
+  std::vector<std::vector<int> > nested(2, MakeSequence(2));
+  EXPECT_EQ("...,...", GetLimitedString(nested, LimitPrinting(0, 1)));
+  EXPECT_EQ("0,1,0,1", GetLimitedString(nested, LimitPrinting(0, 2)));
+
+  std::map<int, std::string> map;
+  map.insert(std::make_pair(1, "a"));
+  EXPECT_EQ("...", GetLimitedString(map, LimitPrinting(0, 1)));
+  EXPECT_EQ("(1,a)", GetLimitedString(map, LimitPrinting(0, 2)));
+}
+
+TEST(StringBuilderTest, LimitBytes) {
+  const std::vector<int> sequence = MakeSequence(100);
+  EXPECT_EQ("0,1,2,3,...(96 more)",
+            GetLimitedString(sequence, LimitPrinting(0, 0, 7)));
+
+  // Counted over the nested containers.
+  std::vector<std::vector<int> > nested(3, MakeSequence(3));
+  EXPECT_EQ("0,1,2,0,...(2 more),...(1 more)",
+            GetLimitedString(nested, LimitPrinting(0, 0, 7)));
+}
+
+TEST(StringBuilderTest, LimitBytesOfStrings) {
+  const std::string string = "abcdefghij";
+  EXPECT_EQ("abcd...(6 more)",
+            GetLimitedString(string, LimitPrinting(0, 0, 4)));
+  EXPECT_EQ("abcdefghij", GetLimitedString(string, LimitPrinting(0, 0, 10)));
+  EXPECT_EQ("abcd...(6 more)",
+            GetLimitedString("abcdefghij", LimitPrinting(0, 0, 4)));
+  EXPECT_EQ("abcd...(6 more)",
+            GetLimitedString(string.c_str(), LimitPrinting(0, 0, 4)));
+  const char* null_string = NULL;
+  EXPECT_EQ("(null)", GetLimitedString(null_string, LimitPrinting(0, 0, 4)));
+
+  // Strings in containers get the bytes left.
+  std::vector<std::string> strings;
+  strings.push_back("abcdef");
+  strings.push_back("ghij");
+  strings.push_back("klmn");
+  EXPECT_EQ("abcdef,g...(3 more),...(1 more)",
+            GetLimitedString(strings, LimitPrinting(0, 0, 8)));
+}
+
+TEST(StringBuilderTest, LimitContainerWithoutSize) {
+  const std::vector<int> sequence = MakeSequence(5);
+  const SizelessSequence sizeless(&sequence[0], &sequence[0] + 5);
+  EXPECT_EQ("0,1,...(3 more)",
+            GetLimitedString(sizeless, LimitPrinting(2)));
+}
+
+TEST(StringBuilderTest, LimitLargeList) {
+  std::list<int> list;
+  for (int i = 0; i < 1000000; ++i) {
+    list.push_back(i);
+  }
+  EXPECT_EQ("0,...(999999 more)", GetLimitedString(list, LimitPrinting(1)));
+}
+
+TEST(StringBuilderTest, LimitsOfEachStream) {
+  const std::vector<int> sequence = MakeSequence(3);
+  MessageStream stream;
+  PutAsString(LimitPrinting(1), stream);
+  PutAsString(sequence, stream);
+  PutAsString(sequence, stream);
+  EXPECT_EQ("0,...(2 more)0,...(2 more)", stream.str());
+
+  EXPECT_EQ("0,1,2", GetLimitedString(sequence, GetPrintLimits()));
+}
+
+TEST(StringBuilderTest, DefaultLimits) {
+  SetPrintLimits(LimitPrinting(2));
+  const std::vector<int> sequence = MakeSequence(3);
+  MessageStream stream;
+  PutAsString(sequence, stream);
+  EXPECT_EQ("0,1,...(1 more)", stream.str());
+  SetPrintLimits(LimitPrinting(0));
+
+  // Streams without the state are not limited.
+  VerifyStringOfValue(sequence, "0,1,2");
+}
+
 }  // namespace LOG
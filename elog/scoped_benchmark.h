@@ -4,36 +4,84 @@
 #ifndef ELOG_SCOPED_BENCHMARK_H_
 #define ELOG_SCOPED_BENCHMARK_H_
 
+#include "config.h"
+
+#include <cstddef>
 #include <string>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/memory>
+#else
+# include <memory>
+#endif
 #include "benchmark_suite.h"
+#include "benchmark_trace.h"
+#include "clock.h"
 #include "elog.h"
 #include "general_log.h"
+#include "perf_counters.h"
 #include "safe_bool.h"
-#include "timer.h"
 
 namespace LOG {
 
 template <LogLevel LEVEL>
 class ScopedBenchmark : public SafeBool<ScopedBenchmark<LEVEL> > {
  public:
+  // Inactive benchmark, which measures and prints nothing.
+  ScopedBenchmark()
+      : source_file_name_(NULL),
+        line_number_(0),
+        logger_(NULL),
+        start_time_(),
+        suite_(NULL),
+        case_id_(0),
+        traced_(false),
+        logged_(false),
+        done_(true) {
+  }
+
+  // The start and end messages are not built if the logger discards them,
+  // while the suite and the trace still record the scope.
   ScopedBenchmark(const std::string& title,
                   const char* source_file_name,
                   int line_number,
                   BenchmarkSuite* suite = NULL,
-                  Logger* logger = NULL)
-      : general_log_(source_file_name, line_number, logger),
-        title_(title),
+                  Logger* logger = NULL,
+                  BenchmarkCaseSite* case_site = NULL)
+      : title_(title),
+        source_file_name_(source_file_name),
+        line_number_(line_number),
+        logger_(logger),
+        perf_counters_(IsPerfCountersEnabled() ? new PerfCounters : NULL),
+        start_time_(Clock::Now()),
         suite_(suite),
+        case_id_(0),
+        traced_(IsBenchmarkTraceEnabled()),
+        logged_(IsLogged(logger)),
         done_(false) {
-    GeneralLog<LEVEL> start_log(source_file_name, line_number, logger);
-    start_log << title << ": start...";
-    start_log.PushMessage();
+    if (suite_) {
+      case_id_ = suite_->EnterScope(case_site, title);
+    }
+    if (logged_) {
+      GeneralLog<LEVEL> start_log(source_file_name, line_number, logger);
+      start_log << title << ": start...";
+      start_log.PushMessage();
+    }
+    if (traced_) {
+      BeginBenchmarkTrace(title_);
+    }
   }
 
   ScopedBenchmark(const ScopedBenchmark& scoped_benchmark)
-      : general_log_(scoped_benchmark.general_log_),
-        title_(scoped_benchmark.title_),
+      : title_(scoped_benchmark.title_),
+        source_file_name_(scoped_benchmark.source_file_name_),
+        line_number_(scoped_benchmark.line_number_),
+        logger_(scoped_benchmark.logger_),
+        perf_counters_(scoped_benchmark.perf_counters_),
+        start_time_(scoped_benchmark.start_time_),
         suite_(scoped_benchmark.suite_),
+        case_id_(scoped_benchmark.case_id_),
+        traced_(scoped_benchmark.traced_),
+        logged_(scoped_benchmark.logged_),
         done_(scoped_benchmark.done_) {
   }
 
@@ -45,8 +93,10 @@ class ScopedBenchmark : public SafeBool<ScopedBenchmark<LEVEL> > {
     return false;
   }
 
+  // Zero if inactive.
   double GetTime() const {
-    return timer_.GetTime();
+    return source_file_name_ ?
+        Clock::ToNanoSec(Clock::Now() - start_time_) * 1e-9 : 0;
   }
 
   void Print() {
@@ -57,19 +107,48 @@ class ScopedBenchmark : public SafeBool<ScopedBenchmark<LEVEL> > {
   }
 
  private:
+  static bool IsLogged(Logger* logger) {
+    return GeneralLog<LEVEL>::kIsCompiledIn &&
+        (LEVEL >= FATAL ||
+         (logger ? *logger : GetLogger()).IsLevelEnabled(LEVEL));
+  }
+
   void PrintWithoutCheck() {
-    const double time = timer_.GetTime();
+    const double time = GetTime();
+    PerfCounterValues perf_counter_values;
+    const bool has_perf_counters =
+        perf_counters_ && perf_counters_->IsAvailable();
+    if (has_perf_counters) {
+      perf_counters_->GetDeltas(perf_counter_values);
+    }
+    if (traced_) {
+      EndBenchmarkTrace(title_);
+    }
     if (suite_) {
-      suite_->AddCase(title_, time);
+      suite_->ExitScope(case_id_, time,
+                        has_perf_counters ? &perf_counter_values : NULL);
+    }
+    if (!logged_) return;
+    GeneralLog<LEVEL> end_log(source_file_name_, line_number_, logger_);
+    end_log << title_ << ": " << time << " sec";
+    if (has_perf_counters) {
+      end_log << " (";
+      PrintPerfCounterValues(perf_counter_values, end_log);
+      end_log << ')';
     }
-    general_log_ << title_ << ": " << time << " sec";
-    general_log_.PushMessage();
+    end_log.PushMessage();
   }
 
-  GeneralLog<LEVEL> general_log_;
   std::string title_;
-  Timer timer_;
+  const char* source_file_name_;
+  int line_number_;
+  Logger* logger_;
+  std::tr1::shared_ptr<PerfCounters> perf_counters_;  // opened before start
+  Clock::Tick start_time_;
   BenchmarkSuite* suite_;
+  std::size_t case_id_;
+  bool traced_;
+  bool logged_;
 
   bool done_;
 };
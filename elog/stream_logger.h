@@ -6,27 +6,156 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <string>
+#include <vector>
 #ifdef ELOG_I_USE_TR1_HEADER
-# include <tr1/unordered_map>
+# include <tr1/functional>
 #else
-# include <unordered_map>
+# include <functional>
 #endif
 #include "atomic.h"
+#include "clock.h"
 #include "logger.h"
+#include "message_stream.h"
 #include "mutex.h"
+#include "thread.h"
+#include "timestamp_formatter.h"
+#include "util.h"
+#include "verbosity_table.h"
 
 namespace LOG {
 
-class StreamLogger : public Logger {
+enum FlushPolicy {
+  FLUSH_EVERY_LINE,
+  FLUSH_EVERY_N_LINES,
+  FLUSH_PERIODICALLY,
+  FLUSH_ON_SEVERITY
+};
+
+template <AvoidODR>
+struct StreamLoggerCountTemplate {
+  static volatile std::size_t value;
+};
+
+template <AvoidODR N>
+volatile std::size_t StreamLoggerCountTemplate<N>::value;
+
+typedef StreamLoggerCountTemplate<AVOID_ODR> StreamLoggerCount;
+
+// Shard of the StreamLogger which the thread last appended to, and the serial
+// of the logger.
+template <typename Shard>
+struct ThreadShardCache {
+  static ELOG_I_THREAD_LOCAL std::size_t logger_serial;
+  static ELOG_I_THREAD_LOCAL Shard* shard;
+};
+
+template <typename Shard>
+ELOG_I_THREAD_LOCAL std::size_t ThreadShardCache<Shard>::logger_serial;
+
+template <typename Shard>
+ELOG_I_THREAD_LOCAL Shard* ThreadShardCache<Shard>::shard;
+
+// Logger writing messages to std::ostream. By default the stream is flushed
+// after every line; the other flush policies leave lines in the buffer of the
+// stream to save system calls. FATAL and CHECK messages are always flushed.
+// Messages other than raw ones can be prefixed by the wall clock time.
+//
+// Messages are written under a lock by default. With sharded buffers enabled,
+// each thread instead appends lines to its own buffer, which it finds through
+// a thread-local cache, and a background thread merges the buffers in
+// timestamp order and writes them to the stream in batches. Lines are ordered
+// within each batch only: a line appended while a batch is taken out may go to
+// the next batch even if it is earlier than lines of this one. A buffer is
+// made for each thread which logs, and is kept until the logger is destroyed.
+class StreamLogger : public Logger, Noncopyable {
  public:
   explicit StreamLogger(std::ostream& stream = std::clog)
-      : stream_(stream),
-        level_(INFO) {
+      : serial_(FetchAndAdd(StreamLoggerCount::value, 1) + 1),
+        stream_(stream),
+        flush_policy_(FLUSH_EVERY_LINE),
+        flush_interval_lines_(1),
+        flush_level_(INFO),
+        timestamp_precision_(NO_TIMESTAMP),
+        unflushed_line_count_(0),
+        flusher_(NULL),
+        is_flusher_stopped_(false),
+        is_sharded_(false),
+        combiner_(NULL),
+        is_combiner_stopped_(false) {
+  }
+
+  virtual ~StreamLogger() {
+    StopThread(flusher_, is_flusher_stopped_);
+    StopThread(combiner_, is_combiner_stopped_);
+    CombineShards();
+    stream_.flush();
+    std::for_each(shards_.begin(), shards_.end(), CheckedDelete<Shard>);
+  }
+
+  FlushPolicy flush_policy() const {
+    return flush_policy_;
   }
 
-  void set_level(LogLevel level) {
-    level_ = level;
+  void SetFlushEveryLine() {
+    SetFlushPolicy(FLUSH_EVERY_LINE, 1, INFO);
+  }
+
+  void SetFlushEveryNLines(int num_lines) {
+    SetFlushPolicy(FLUSH_EVERY_N_LINES, num_lines, INFO);
+  }
+
+  // Flushes buffered lines from a background thread.
+  void SetFlushPeriodically(int interval_milli_sec) {
+    SetFlushPolicy(FLUSH_PERIODICALLY, 1, INFO);
+    StartThread(&StreamLogger::FlushIfNeeded, interval_milli_sec,
+                flusher_, is_flusher_stopped_);
+  }
+
+  // Flushes at each message at least as severe as the level. Typed messages
+  // are regarded as INFO.
+  void SetFlushOnSeverity(LogLevel level) {
+    SetFlushPolicy(FLUSH_ON_SEVERITY, 1, level);
+  }
+
+  TimestampPrecision timestamp_precision() const {
+    return timestamp_precision_;
+  }
+
+  void set_timestamp_precision(TimestampPrecision timestamp_precision) {
+    timestamp_precision_ = timestamp_precision;
+  }
+
+  bool is_sharded() const {
+    return is_sharded_;
+  }
+
+  // Switches to sharded buffers, which are written every interval. The stream
+  // is flushed after each batch regardless of the flush policy.
+  void EnableShardedBuffers(int interval_milli_sec) {
+    StopThread(combiner_, is_combiner_stopped_);
+    is_sharded_ = true;
+    StartThread(&StreamLogger::CombineShards, interval_milli_sec,
+                combiner_, is_combiner_stopped_);
+  }
+
+  // Lines being appended to the buffers are written before this returns, or
+  // under the lock after it.
+  void DisableShardedBuffers() {
+    StopThread(combiner_, is_combiner_stopped_);
+    MutexLock lock(push_message_mutex_);
+    is_sharded_ = false;
+    CombineShardsWithoutLock();
+  }
+
+  // Writes the sharded buffers, if any, and flushes the stream.
+  void Flush() {
+    MutexLock lock(push_message_mutex_);
+    CombineShardsWithoutLock();
+    FlushWithoutLock();
   }
 
   template <typename T>
@@ -35,38 +164,62 @@ class StreamLogger : public Logger {
   }
 
   void SetTypeVerbosity(TypeInfo type_info, int verbosity) {
-    MutexLock lock(verbosity_mutex_);
-    verbosities_[type_info] = verbosity;
+    verbosities_.Set(type_info, verbosity);
   }
 
   void ResetVerbosities() {
-    verbosities_.clear();
+    verbosities_.Clear();
+  }
+
+  virtual int GetTypeVerbosity(TypeInfo type_info) const {
+    return verbosities_.Get(type_info);
   }
 
   virtual void PushRawMessage(LogLevel level, const std::string& message) {
-    if (!IsLogLevelSevereEnough(level, level_)) return;
-    stream_ << message << std::endl;
+    if (!IsLevelEnabled(level)) return;
+    if (is_sharded_) {
+      const MessageStream no_header;
+      if (AppendToShard(level, false, no_header,
+                        message.data(), message.size())) {
+        return;
+      }
+    }
+    MutexLock lock(push_message_mutex_);
+    stream_ << message << '\n';
+    EndLine(level);
   }
 
   virtual void PushMessage(LogLevel level,
                            const char* source_file_name,
                            int line_number,
                            const std::string& message) {
-    if (!IsLogLevelSevereEnough(level, level_)) return;
-    PushMessageWithoutCheck(level, source_file_name, line_number, message);
+    PushMessage(level, source_file_name, line_number,
+                message.data(), message.size());
+  }
+
+  virtual void PushMessage(LogLevel level,
+                           const char* source_file_name,
+                           int line_number,
+                           const char* message,
+                           std::size_t message_size) {
+    if (!IsLevelEnabled(level)) return;
+    PushMessageWithoutCheck(level, source_file_name, line_number,
+                            message, message_size);
   }
 
   virtual void PushFatalMessageAndThrow(const char* source_file_name,
                                         int line_number,
                                         const std::string& message) {
-    PushMessageWithoutCheck(FATAL, source_file_name, line_number, message);
+    PushMessageWithoutCheck(FATAL, source_file_name, line_number,
+                            message.data(), message.size());
     throw FatalLogError();
   }
 
   virtual void PushCheckMessageAndThrow(const char* source_file_name,
                                         int line_number,
                                         const std::string& message) {
-    PushMessageWithoutCheck(CHECK, source_file_name, line_number, message);
+    PushMessageWithoutCheck(CHECK, source_file_name, line_number,
+                            message.data(), message.size());
     throw CheckError();
   }
 
@@ -75,33 +228,337 @@ class StreamLogger : public Logger {
                                 const char* source_file_name,
                                 int line_number,
                                 const std::string& message) {
-    {
-      MutexLock verbosity_lock(verbosity_mutex_);
-      const int type_verbosity = verbosities_[type_info];
-      if (IsVerboseEnough(verbosity, type_verbosity)) return;
+    PushTypedMessage(type_info, verbosity, source_file_name, line_number,
+                     message.data(), message.size());
+  }
+
+  virtual void PushTypedMessage(TypeInfo type_info,
+                                int verbosity,
+                                const char* source_file_name,
+                                int line_number,
+                                const char* message,
+                                std::size_t message_size) {
+    const int type_verbosity = verbosities_.Get(type_info);
+    if (IsVerboseEnough(verbosity, type_verbosity)) return;
+    if (is_sharded_) {
+      char buffer[kHeaderBufferSize];
+      MessageStream header(buffer, sizeof(buffer));
+      OutputTypedMessageHeader(type_info, verbosity, header);
+      OutputFileLine(source_file_name, line_number, header);
+      if (AppendToShard(INFO, true, header, message, message_size)) return;
     }
     MutexLock lock(push_message_mutex_);
-    OutputTypedMessageHeader(type_info, verbosity, stream_);
-    OutputFileLine(source_file_name, line_number, stream_);
-    stream_ << message << std::endl;
+    OutputTimestamp();
+    OutputTypedMessage(type_info, verbosity, source_file_name, line_number,
+                       message, message_size, stream_);
+    EndLine(INFO);
   }
 
  private:
+  // Enough for the headers but of long file or type names, which spill to
+  // the heap.
+  static const std::size_t kHeaderBufferSize = 256;
+
+  // Line in a sharded buffer, which ends at the given offset of the text.
+  struct ShardedLine {
+    MonotonicClock::Tick timestamp;
+    std::size_t end;
+  };
+
+  struct ShardBuffer {
+    std::string text;
+    std::vector<ShardedLine> lines;
+  };
+
+  // Buffer of a thread. The mutex is only contended by the combiner.
+  struct Shard {
+    std::size_t thread_index;  // GetThreadIndex() of the thread
+    Mutex mutex;
+    ShardBuffer buffer;
+    TimestampFormatter timestamp_formatter;
+  };
+
+  // Next line to write in a batch taken out of a shard.
+  struct BatchCursor {
+    MonotonicClock::Tick timestamp;
+    std::size_t batch;
+    std::size_t line;
+  };
+
+  // Puts the earliest line at the top of a heap. Ties are broken by the
+  // shard, so that lines of the same time are written in a stable order.
+  static bool IsLater(const BatchCursor& lhs, const BatchCursor& rhs) {
+    return lhs.timestamp > rhs.timestamp ||
+        (lhs.timestamp == rhs.timestamp && lhs.batch > rhs.batch);
+  }
+
+  template <typename Stream>
+  static void OutputMessage(LogLevel level,
+                            const char* source_file_name,
+                            int line_number,
+                            const char* message,
+                            std::size_t message_size,
+                            Stream& stream) {
+    OutputLogLevelName(level, stream);
+    OutputFileLine(source_file_name, line_number, stream);
+    stream.write(message, message_size);
+    stream.put('\n');
+  }
+
+  template <typename Stream>
+  static void OutputTypedMessage(TypeInfo type_info,
+                                 int verbosity,
+                                 const char* source_file_name,
+                                 int line_number,
+                                 const char* message,
+                                 std::size_t message_size,
+                                 Stream& stream) {
+    OutputTypedMessageHeader(type_info, verbosity, stream);
+    OutputFileLine(source_file_name, line_number, stream);
+    stream.write(message, message_size);
+    stream.put('\n');
+  }
+
   void PushMessageWithoutCheck(LogLevel level,
                                const char* source_file_name,
                                int line_number,
-                               const std::string& message) {
+                               const char* message,
+                               std::size_t message_size) {
+    if (is_sharded_) {
+      char buffer[kHeaderBufferSize];
+      MessageStream header(buffer, sizeof(buffer));
+      OutputLogLevelName(level, header);
+      OutputFileLine(source_file_name, line_number, header);
+      if (AppendToShard(level, true, header, message, message_size)) return;
+    }
     MutexLock lock(push_message_mutex_);
-    OutputLogLevelName(level, stream_);
-    OutputFileLine(source_file_name, line_number, stream_);
-    stream_ << message << std::endl;
+    OutputTimestamp();
+    OutputMessage(level, source_file_name, line_number,
+                  message, message_size, stream_);
+    EndLine(level);
+  }
+
+  // Called with push_message_mutex_ locked before each line.
+  void OutputTimestamp() {
+    char timestamp[TimestampFormatter::kMaxSize];
+    stream_.write(timestamp,
+                  timestamp_formatter_.Format(timestamp_precision_, timestamp));
   }
 
+  // Called with push_message_mutex_ locked after each line.
+  void EndLine(LogLevel level) {
+    ++unflushed_line_count_;
+    if (level >= FATAL) {
+      FlushWithoutLock();
+      return;
+    }
+    switch (flush_policy_) {
+      case FLUSH_EVERY_LINE:
+        FlushWithoutLock();
+        break;
+      case FLUSH_EVERY_N_LINES:
+        if (unflushed_line_count_ >= flush_interval_lines_) {
+          FlushWithoutLock();
+        }
+        break;
+      case FLUSH_PERIODICALLY:
+        break;
+      case FLUSH_ON_SEVERITY:
+        if (IsLogLevelSevereEnough(level, flush_level_)) {
+          FlushWithoutLock();
+        }
+        break;
+    }
+  }
+
+  void FlushWithoutLock() {
+    stream_.flush();
+    unflushed_line_count_ = 0;
+  }
+
+  void FlushIfNeeded() {
+    MutexLock lock(push_message_mutex_);
+    if (unflushed_line_count_) {
+      FlushWithoutLock();
+    }
+  }
+
+  void SetFlushPolicy(FlushPolicy flush_policy,
+                      int flush_interval_lines,
+                      LogLevel flush_level) {
+    StopThread(flusher_, is_flusher_stopped_);
+    MutexLock lock(push_message_mutex_);
+    flush_policy_ = flush_policy;
+    flush_interval_lines_ = std::max(flush_interval_lines, 1);
+    flush_level_ = flush_level;
+    FlushWithoutLock();
+  }
+
+  // Appends the header, the message and a newline to the buffer of the
+  // thread. Returns false if the buffers are no longer sharded, in which case
+  // the line is to be written under the lock. FATAL and CHECK lines are
+  // written at once with all the buffered lines.
+  bool AppendToShard(LogLevel level,
+                     bool has_timestamp,
+                     const MessageStream& header,
+                     const char* message,
+                     std::size_t message_size) {
+    Shard& shard = GetThreadShard();
+    {
+      MutexLock lock(shard.mutex);
+      // DisableShardedBuffers() clears the flag before it takes the lock of
+      // each shard to write the last lines.
+      if (!is_sharded_) return false;
+      ShardBuffer& buffer = shard.buffer;
+      if (has_timestamp) {
+        char timestamp[TimestampFormatter::kMaxSize];
+        buffer.text.append(timestamp, shard.timestamp_formatter.Format(
+            timestamp_precision_, timestamp));
+      }
+      buffer.text.append(header.data(), header.size());
+      buffer.text.append(message, message_size);
+      buffer.text += '\n';
+      const ShardedLine sharded_line = {
+        MonotonicClock::Now(), buffer.text.size()
+      };
+      buffer.lines.push_back(sharded_line);
+    }
+    if (level >= FATAL) {
+      Flush();
+    }
+    return true;
+  }
+
+  // The shard is looked up under the lock only when the thread appends to
+  // another logger than the last one.
+  Shard& GetThreadShard() {
+    typedef ThreadShardCache<Shard> Cache;
+    if (Cache::logger_serial == serial_) {
+      return *Cache::shard;
+    }
+    const std::size_t thread_index = GetThreadIndex();
+    Shard* shard = NULL;
+    {
+      MutexLock lock(push_message_mutex_);
+      for (std::size_t i = 0; i < shards_.size() && !shard; ++i) {
+        if (shards_[i]->thread_index == thread_index) {
+          shard = shards_[i];
+        }
+      }
+      if (!shard) {
+        shard = new Shard;
+        shard->thread_index = thread_index;
+        shards_.push_back(shard);
+        batches_.resize(shards_.size());
+      }
+    }
+    Cache::logger_serial = serial_;
+    Cache::shard = shard;
+    return *shard;
+  }
+
+  void CombineShards() {
+    MutexLock lock(push_message_mutex_);
+    CombineShardsWithoutLock();
+  }
+
+  // Takes the lines out of the shards, and writes them ordered by timestamp.
+  // Lines of each shard are already ordered, so the shards are merged. The
+  // buffers are swapped one by one, so that their memory is reused and no
+  // thread waits for the others; hence the order holds only in the batch.
+  void CombineShardsWithoutLock() {
+    cursors_.clear();
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+      ShardBuffer& batch = batches_[i];
+      {
+        MutexLock lock(shards_[i]->mutex);
+        batch.text.swap(shards_[i]->buffer.text);
+        batch.lines.swap(shards_[i]->buffer.lines);
+      }
+      if (!batch.lines.empty()) {
+        const BatchCursor cursor = { batch.lines[0].timestamp, i, 0 };
+        cursors_.push_back(cursor);
+      }
+    }
+    if (cursors_.empty()) return;
+
+    std::make_heap(cursors_.begin(), cursors_.end(), IsLater);
+    while (!cursors_.empty()) {
+      std::pop_heap(cursors_.begin(), cursors_.end(), IsLater);
+      BatchCursor& cursor = cursors_.back();
+      const ShardBuffer& batch = batches_[cursor.batch];
+      const std::size_t begin =
+          cursor.line ? batch.lines[cursor.line - 1].end : 0;
+      stream_.write(batch.text.data() + begin,
+                    batch.lines[cursor.line].end - begin);
+      if (++cursor.line < batch.lines.size()) {
+        cursor.timestamp = batch.lines[cursor.line].timestamp;
+        std::push_heap(cursors_.begin(), cursors_.end(), IsLater);
+      } else {
+        cursors_.pop_back();
+      }
+    }
+    FlushWithoutLock();
+    for (std::size_t i = 0; i < batches_.size(); ++i) {
+      batches_[i].text.clear();
+      batches_[i].lines.clear();
+    }
+  }
+
+  void StartThread(void (StreamLogger::*task)(),
+                   int interval_milli_sec,
+                   Thread*& thread,
+                   volatile bool& is_stopped) {
+    is_stopped = false;
+    thread = new Thread(std::tr1::bind(
+        &StreamLogger::RunPeriodically, this, task, interval_milli_sec,
+        &is_stopped));
+    thread->Run();
+  }
+
+  static void StopThread(Thread*& thread, volatile bool& is_stopped) {
+    if (!thread) return;
+    is_stopped = true;
+    thread->Join();
+    delete thread;
+    thread = NULL;
+  }
+
+  void RunPeriodically(void (StreamLogger::*task)(),
+                       int interval_milli_sec,
+                       const volatile bool* is_stopped) {
+    static const int kMaxSleepMilliSec = 10;
+
+    while (!*is_stopped) {
+      for (int slept = 0;
+           slept < interval_milli_sec && !*is_stopped;
+           slept += kMaxSleepMilliSec) {
+        SleepMilliSec(std::min(kMaxSleepMilliSec, interval_milli_sec - slept));
+      }
+      (this->*task)();
+    }
+  }
+
+  const std::size_t serial_;  // distinguishes loggers in ThreadShardCache
   std::ostream& stream_;
   Mutex push_message_mutex_;
-  Mutex verbosity_mutex_;
-  LogLevel level_;
-  std::tr1::unordered_map<TypeInfo, int, TypeInfo::Hash> verbosities_;
+  VerbosityTable verbosities_;
+
+  FlushPolicy flush_policy_;
+  int flush_interval_lines_;
+  LogLevel flush_level_;
+  volatile TimestampPrecision timestamp_precision_;
+  TimestampFormatter timestamp_formatter_;  // used by OutputTimestamp()
+  int unflushed_line_count_;
+  Thread* flusher_;
+  volatile bool is_flusher_stopped_;
+
+  volatile bool is_sharded_;
+  std::vector<Shard*> shards_;  // guarded by push_message_mutex_
+  std::vector<ShardBuffer> batches_;  // used by CombineShardsWithoutLock()
+  std::vector<BatchCursor> cursors_;  // ditto
+  Thread* combiner_;
+  volatile bool is_combiner_stopped_;
 };
 
 }  // namespace LOG
@@ -0,0 +1,190 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the filtering of typed messages by StreamLogger under contention:
+// the former mutex-protected map against VerbosityTable. Also measures the
+// cost of writing messages to a file under each flush policy, and the cost of
+// timestamp prefixes against localtime_r() and strftime() at every line.
+
+#include "config.h"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+# include <tr1/unordered_map>
+#else
+# include <functional>
+# include <unordered_map>
+#endif
+#include "mutex.h"
+#include "stream_logger.h"
+#include "thread.h"
+#include "timer.h"
+#include "timestamp_formatter.h"
+#include "type_info.h"
+#include "verbosity_table.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+const int kMaxNumThreads = 8;
+const int kNumFileMessages = 200000;
+const char* kPath = "stream_logger_benchmark.log";
+
+class SomeModule {};
+
+// The implementation of StreamLogger::PushTypedMessage before VerbosityTable.
+class LockedVerbosityMap {
+ public:
+  int Get(LOG::TypeInfo type_info) {
+    LOG::MutexLock lock(mutex_);
+    return verbosities_[type_info];
+  }
+
+ private:
+  LOG::Mutex mutex_;
+  std::tr1::unordered_map<LOG::TypeInfo, int, LOG::TypeInfo::Hash>
+      verbosities_;
+};
+
+template <typename Table>
+void LookUp(Table* table, volatile int* sum) {
+  const LOG::TypeInfo type_info((LOG::Type<SomeModule>()));
+  int local_sum = 0;
+  for (int i = 0; i < kNumIterations; ++i) {
+    local_sum += table->Get(type_info);
+  }
+  *sum += local_sum;
+}
+
+void PushDroppedTypedMessages(LOG::StreamLogger* logger, volatile int*) {
+  const LOG::TypeInfo type_info((LOG::Type<SomeModule>()));
+  const std::string message = "message";
+  for (int i = 0; i < kNumIterations; ++i) {
+    logger->PushTypedMessage(type_info, 1, __FILE__, __LINE__, message);
+  }
+}
+
+// Returns nanoseconds per call seen by each thread.
+template <typename Table>
+double Run(void (*body)(Table*, volatile int*), Table* table,
+           int num_threads) {
+  volatile int sum = 0;
+  std::vector<LOG::Thread*> threads;
+  LOG::Timer timer;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(new LOG::Thread(std::tr1::bind(body, table, &sum)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  return timer.GetTime() * 1e9 / kNumIterations;
+}
+
+enum FileFlushPolicy {
+  EVERY_LINE,
+  EVERY_64_LINES,
+  EVERY_100_MILLI_SEC,
+  ON_ERROR
+};
+
+// Returns nanoseconds per message written to a file.
+double WriteFile(FileFlushPolicy flush_policy) {
+  std::ofstream file(kPath);
+  LOG::StreamLogger logger(file);
+  switch (flush_policy) {
+    case EVERY_LINE:
+      logger.SetFlushEveryLine();
+      break;
+    case EVERY_64_LINES:
+      logger.SetFlushEveryNLines(64);
+      break;
+    case EVERY_100_MILLI_SEC:
+      logger.SetFlushPeriodically(100);
+      break;
+    case ON_ERROR:
+      logger.SetFlushOnSeverity(LOG::ERROR);
+      break;
+  }
+
+  LOG::Timer timer;
+  for (int i = 0; i < kNumFileMessages; ++i) {
+    logger.PushMessage(LOG::INFO, __FILE__, __LINE__, "message");
+  }
+  const double time = timer.GetTime();
+  std::remove(kPath);
+  return time * 1e9 / kNumFileMessages;
+}
+
+// Returns nanoseconds per timestamp formatted as lite/elog.hpp did.
+double FormatByStrftime() {
+  std::size_t sum = 0;
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    const std::time_t now = std::time(NULL);
+    std::tm tm;
+    localtime_r(&now, &tm);
+    char buffer[64];
+    sum += std::strftime(buffer, sizeof(buffer), "[%Y%m%d %X] ", &tm);
+  }
+  const double time = timer.GetTime();
+  return sum ? time * 1e9 / kNumIterations : 0;
+}
+
+// Returns nanoseconds per timestamp formatted by TimestampFormatter.
+double FormatByFormatter(LOG::TimestampPrecision precision) {
+  LOG::TimestampFormatter formatter;
+  std::size_t sum = 0;
+  LOG::Timer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    char buffer[LOG::TimestampFormatter::kMaxSize];
+    sum += formatter.Format(precision, buffer);
+  }
+  const double time = timer.GetTime();
+  return sum ? time * 1e9 / kNumIterations : 0;
+}
+
+}  // anonymous namespace
+
+int main() {
+  LockedVerbosityMap locked_map;
+  LOG::VerbosityTable verbosity_table;
+  std::ostringstream stream;
+  LOG::StreamLogger logger(stream);
+
+  std::cout << "threads | mutex+map (ns) | VerbosityTable (ns)"
+            << " | dropped PushTypedMessage (ns)" << std::endl;
+  for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+    std::cout << num_threads
+              << " | " << Run(LookUp<LockedVerbosityMap>, &locked_map,
+                              num_threads)
+              << " | " << Run(LookUp<LOG::VerbosityTable>, &verbosity_table,
+                              num_threads)
+              << " | " << Run(PushDroppedTypedMessages, &logger, num_threads)
+              << std::endl;
+  }
+
+  std::cout << std::endl
+            << "every line (ns) | every 64 lines (ns) | every 100 ms (ns)"
+            << " | on ERROR (ns)" << std::endl
+            << WriteFile(EVERY_LINE)
+            << " | " << WriteFile(EVERY_64_LINES)
+            << " | " << WriteFile(EVERY_100_MILLI_SEC)
+            << " | " << WriteFile(ON_ERROR) << std::endl;
+
+  std::cout << std::endl
+            << "strftime (ns) | cached, sec (ns) | cached, micro sec (ns)"
+            << std::endl
+            << FormatByStrftime()
+            << " | " << FormatByFormatter(LOG::TIMESTAMP_IN_SEC)
+            << " | " << FormatByFormatter(LOG::TIMESTAMP_IN_MICRO_SEC)
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures how the cost of StreamLogger::PushMessage scales with the number
+// of threads, with the stream written under a lock and with sharded buffers.
+// Messages are written to a stream which discards them.
+
+#include "config.h"
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
+#include "stream_logger.h"
+#include "thread.h"
+#include "timer.h"
+
+namespace {
+
+const int kNumMessagesPerThread = 100000;
+const int kMaxNumThreads = 64;
+
+class NullBuffer : public std::streambuf {
+ protected:
+  virtual int_type overflow(int_type c) {
+    return traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn(const char*, std::streamsize n) {
+    return n;
+  }
+};
+
+void PushMessages(LOG::StreamLogger* logger) {
+  for (int i = 0; i < kNumMessagesPerThread; ++i) {
+    logger->PushMessage(LOG::INFO, __FILE__, __LINE__,
+                        "a message of typical length", 27);
+  }
+}
+
+// Returns nanoseconds per message in total.
+double Run(bool is_sharded, int num_threads) {
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  LOG::StreamLogger logger(stream);
+  logger.SetFlushEveryNLines(1024);
+  if (is_sharded) {
+    logger.EnableShardedBuffers(10);
+  }
+
+  LOG::Timer timer;
+  std::vector<LOG::Thread*> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(new LOG::Thread(std::tr1::bind(PushMessages, &logger)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  logger.Flush();
+  return timer.GetTime() * 1e9 / (num_threads * kNumMessagesPerThread);
+}
+
+}  // anonymous namespace
+
+int main() {
+  std::cout << "threads | locked (ns/message) | sharded (ns/message)"
+            << std::endl;
+  for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+    std::cout << num_threads
+              << " | " << Run(false, num_threads)
+              << " | " << Run(true, num_threads) << std::endl;
+  }
+  return 0;
+}
@@ -1,12 +1,59 @@
 // Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
 // This source code is distributed under MIT License in LICENSE file.
 
+#include "config.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <sstream>
+#include <streambuf>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
 #include <gtest/gtest.h>
+#include "elog.h"
 #include "stream_logger.h"
+#include "thread.h"
 using namespace std;
 
+namespace {
+
+volatile std::size_t allocation_count = 0;
+
+// Not inlined, so that the compiler does not pair malloc in operator new with
+// free in operator delete.
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void Deallocate(void* ptr) {
+  std::free(ptr);
+}
+
+}  // anonymous namespace
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) throw() {
+  Deallocate(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* ptr, std::size_t) throw() {
+  Deallocate(ptr);
+}
+#endif
+
 namespace LOG {
 
 namespace {
@@ -40,6 +87,46 @@ void VerifyPushMessage(LogLevel level) {
   EXPECT_NE(std::string::npos, full_message.find(kMessage));
 }
 
+// Stream buffer which discards characters and counts flushes.
+class SomeModule {};
+
+class FlushCountingBuffer : public std::streambuf {
+ public:
+  FlushCountingBuffer() : flush_count_(0) {}
+
+  int flush_count() const {
+    return flush_count_;
+  }
+
+ protected:
+  virtual int_type overflow(int_type c) {
+    return traits_type::not_eof(c);
+  }
+
+  virtual int sync() {
+    ++flush_count_;
+    return 0;
+  }
+
+ private:
+  volatile int flush_count_;
+};
+
+void PushMessages(StreamLogger& logger, LogLevel level, int count) {
+  for (int i = 0; i < count; ++i) {
+    logger.PushMessage(level, "source file name", 10, kMessage);
+  }
+}
+
+// Pushes messages "<thread> <i>" for i = 0, 1, ....
+void PushNumberedMessages(StreamLogger* logger, int thread, int count) {
+  for (int i = 0; i < count; ++i) {
+    std::ostringstream message;
+    message << thread << ' ' << i;
+    logger->PushMessage(INFO, "file", 1, message.str());
+  }
+}
+
 }  // anonymous namespace
 
 TEST(StreamLoggerTest, PushMessageINFO) {
@@ -62,6 +149,219 @@ TEST(StreamLoggerTest, PushMessageCHECK) {
   VerifyPushMessage(CHECK);
 }
 
+TEST(StreamLoggerTest, FlushEveryLine) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  PushMessages(logger, INFO, 3);
+  EXPECT_EQ(3, buffer.flush_count());
+}
+
+TEST(StreamLoggerTest, FlushEveryNLines) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  logger.SetFlushEveryNLines(4);
+  const int initial_flush_count = buffer.flush_count();
+  PushMessages(logger, INFO, 10);
+  EXPECT_EQ(2, buffer.flush_count() - initial_flush_count);
+}
+
+TEST(StreamLoggerTest, FlushOnSeverity) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  logger.SetFlushOnSeverity(ERROR);
+  const int initial_flush_count = buffer.flush_count();
+  PushMessages(logger, INFO, 3);
+  PushMessages(logger, WARN, 3);
+  logger.PushTypedMessage(TypeInfo(Type<int>()), 0, "file", 1, kMessage);
+  EXPECT_EQ(initial_flush_count, buffer.flush_count());
+  PushMessages(logger, ERROR, 1);
+  EXPECT_EQ(initial_flush_count + 1, buffer.flush_count());
+}
+
+TEST(StreamLoggerTest, FlushPeriodically) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  logger.SetFlushPeriodically(1);
+  const int initial_flush_count = buffer.flush_count();
+  PushMessages(logger, ERROR, 3);
+  for (int i = 0; i < 1000 && buffer.flush_count() == initial_flush_count;
+       ++i) {
+    SleepMilliSec(1);
+  }
+  EXPECT_LT(initial_flush_count, buffer.flush_count());
+}
+
+TEST(StreamLoggerTest, FatalAndCheckAreAlwaysFlushed) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  logger.SetFlushOnSeverity(CHECK);
+  const int initial_flush_count = buffer.flush_count();
+  EXPECT_THROW(logger.PushFatalMessageAndThrow("file", 1, kMessage),
+               FatalLogError);
+  EXPECT_EQ(initial_flush_count + 1, buffer.flush_count());
+  logger.SetFlushEveryNLines(100);
+  EXPECT_THROW(logger.PushCheckMessageAndThrow("file", 1, kMessage),
+               CheckError);
+  EXPECT_EQ(initial_flush_count + 3, buffer.flush_count());
+}
+
+TEST(StreamLoggerTest, DestructorFlushes) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  {
+    StreamLogger logger(stream);
+    logger.SetFlushEveryNLines(100);
+    PushMessages(logger, INFO, 1);
+    EXPECT_EQ(1, buffer.flush_count());
+  }
+  EXPECT_EQ(2, buffer.flush_count());
+}
+
+TEST(StreamLoggerTest, ShardedBuffers) {
+  static const int kNumThreads = 4;
+  static const int kNumMessages = 1000;
+
+  std::ostringstream stream;
+  StreamLogger logger(stream);
+  logger.EnableShardedBuffers(1);
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(PushNumberedMessages, &logger, i, kNumMessages)));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  logger.Flush();
+
+  // Messages of each thread are written in order.
+  std::istringstream lines(stream.str());
+  std::vector<int> next_numbers(kNumThreads);
+  std::string line;
+  int line_count = 0;
+  while (std::getline(lines, line)) {
+    int thread, number;
+    ASSERT_EQ(2, std::sscanf(line.c_str(), "[INFO] file(1): %d %d",
+                             &thread, &number));
+    ASSERT_EQ(next_numbers[thread], number);
+    ++next_numbers[thread];
+    ++line_count;
+  }
+  EXPECT_EQ(kNumThreads * kNumMessages, line_count);
+}
+
+TEST(StreamLoggerTest, ShardedBuffersAreWrittenPeriodically) {
+  std::ostringstream stream;
+  StreamLogger logger(stream);
+  logger.EnableShardedBuffers(1);
+  PushMessages(logger, INFO, 1);
+  for (int i = 0; i < 1000 && stream.str().empty(); ++i) {
+    SleepMilliSec(1);
+  }
+  EXPECT_NE(std::string::npos, stream.str().find(kMessage));
+
+  logger.DisableShardedBuffers();
+  EXPECT_FALSE(logger.is_sharded());
+}
+
+TEST(StreamLoggerTest, ShardedBuffersWriteFatalAtOnce) {
+  std::ostringstream stream;
+  StreamLogger logger(stream);
+  logger.EnableShardedBuffers(1000000);
+  PushMessages(logger, INFO, 1);
+  EXPECT_THROW(logger.PushFatalMessageAndThrow("file", 1, "fatal"),
+               FatalLogError);
+  const std::string log = stream.str();
+  EXPECT_LT(log.find(kMessage), log.find("fatal"));
+  EXPECT_NE(std::string::npos, log.find("fatal"));
+}
+
+TEST(StreamLoggerTest, DisableShardedBuffersWhilePushing) {
+  static const int kNumThreads = 4;
+  static const int kNumMessages = 1000;
+
+  std::ostringstream stream;
+  StreamLogger logger(stream);
+  logger.EnableShardedBuffers(1000000);
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(
+        std::tr1::bind(PushNumberedMessages, &logger, i, kNumMessages)));
+    threads.back()->Run();
+  }
+  logger.DisableShardedBuffers();
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  // No line is left in the buffers without Flush().
+  std::istringstream lines(stream.str());
+  std::string line;
+  int line_count = 0;
+  while (std::getline(lines, line)) {
+    ++line_count;
+  }
+  EXPECT_EQ(kNumThreads * kNumMessages, line_count);
+}
+
+TEST(StreamLoggerTest, ShardedLogWithoutAllocation) {
+  FlushCountingBuffer buffer;
+  std::ostream stream(&buffer);
+  StreamLogger logger(stream);
+  logger.SetTypeVerbosity<SomeModule>(0);
+  logger.EnableShardedBuffers(1000000);
+  SetLogger(logger);
+  // The buffers grow, and are swapped with the ones of the combiner.
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 100; ++j) {
+      LOG() << "warm up " << j;
+      LOG(SomeModule, 0) << "warm up " << j;
+    }
+    logger.Flush();
+  }
+
+  const std::string value = "value";
+  const std::size_t initial_allocation_count = allocation_count;
+  for (int i = 0; i < 50; ++i) {
+    LOG() << value << ": " << i;
+    LOG(SomeModule, 0) << value << ": " << i;
+  }
+  EXPECT_EQ(initial_allocation_count, allocation_count);
+
+  UseDefaultLogger();
+}
+
+TEST(StreamLoggerTest, Timestamp) {
+  std::ostringstream stream;
+  StreamLogger logger(stream);
+  logger.set_timestamp_precision(TIMESTAMP_IN_MICRO_SEC);
+  logger.PushMessage(INFO, "file", 1, kMessage);
+  logger.PushRawMessage(INFO, "raw");
+  logger.set_timestamp_precision(TIMESTAMP_IN_SEC);
+  logger.PushMessage(INFO, "file", 1, kMessage);
+
+  std::istringstream lines(stream.str());
+  std::string line;
+  int date, hour, minute, sec, micro_sec;
+  char message[16];
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ(6, std::sscanf(line.c_str(), "[%8d %2d:%2d:%2d.%6d] [INFO] %15s",
+                           &date, &hour, &minute, &sec, &micro_sec, message));
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ("raw", line);
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ(5, std::sscanf(line.c_str(), "[%8d %2d:%2d:%2d] [INFO] %15s",
+                           &date, &hour, &minute, &sec, message));
+}
+
 // TODO(S.Tokui): Write multi-thread test.
 
 }  // namespace LOG
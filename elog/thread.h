@@ -4,10 +4,46 @@
 #ifndef ELOG_THREAD_H_
 #define ELOG_THREAD_H_
 
+#include "config.h"
+
+#include <cstddef>
 #ifdef _WIN32
 # include "thread_win32.h"
 #else
 # include "thread_posix.h"
 #endif
+#include "atomic.h"
+#include "util.h"
+
+namespace LOG {
+
+template <AvoidODR>
+struct ThreadIndexTemplate {
+  // Index plus one of the current thread; zero if not assigned yet.
+  static ELOG_I_THREAD_LOCAL std::size_t index;
+  static volatile std::size_t count;
+};
+
+template <AvoidODR N>
+ELOG_I_THREAD_LOCAL std::size_t ThreadIndexTemplate<N>::index;
+
+template <AvoidODR N>
+volatile std::size_t ThreadIndexTemplate<N>::count;
+
+typedef ThreadIndexTemplate<AVOID_ODR> ThreadIndex;
+
+// Returns a small number identifying the current thread: 0 for the first
+// thread calling this function, 1 for the next one, and so on. Numbers are
+// not reused after threads exit.
+inline std::size_t GetThreadIndex() {
+  std::size_t index = ThreadIndex::index;
+  if (!index) {
+    index = FetchAndAdd(ThreadIndex::count, 1) + 1;
+    ThreadIndex::index = index;
+  }
+  return index - 1;
+}
+
+}  // namespace LOG
 
 #endif  // ELOG_THREAD_H_
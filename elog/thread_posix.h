@@ -12,10 +12,23 @@
 # include <functional>
 #endif
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include "util.h"
 
 namespace LOG {
 
+inline void YieldThread() {
+  sched_yield();
+}
+
+inline void SleepMilliSec(int milli_sec) {
+  timespec duration;
+  duration.tv_sec = milli_sec / 1000;
+  duration.tv_nsec = (milli_sec % 1000) * 1000000L;
+  nanosleep(&duration, NULL);
+}
+
 class Thread : Noncopyable {
  public:
   Thread() : is_running_(false) {
@@ -3,6 +3,7 @@
 
 #include "config.h"
 
+#include <cstddef>
 #ifdef ELOG_I_USE_TR1_HEADER
 # include <tr1/functional>
 #else
@@ -32,6 +33,10 @@ class Flag {
   bool flag_;
 };
 
+void StoreThreadIndex(std::size_t* index) {
+  *index = GetThreadIndex();
+}
+
 }  // anonymous namespace
 
 TEST(ThreadTest, CreateAndJoin) {
@@ -45,4 +50,15 @@ TEST(ThreadTest, CreateAndJoin) {
   EXPECT_TRUE(flag.flag());
 }
 
+TEST(ThreadTest, GetThreadIndex) {
+  const std::size_t index = GetThreadIndex();
+  EXPECT_EQ(index, GetThreadIndex());
+
+  std::size_t other_index = index;
+  Thread thread(std::tr1::bind(StoreThreadIndex, &other_index));
+  thread.Run();
+  thread.Join();
+  EXPECT_NE(index, other_index);
+}
+
 }  // namespace LOG
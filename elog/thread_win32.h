@@ -11,6 +11,14 @@
 
 namespace LOG {
 
+inline void YieldThread() {
+  SwitchToThread();
+}
+
+inline void SleepMilliSec(int milli_sec) {
+  Sleep(milli_sec);
+}
+
 class ScopedThreadHandle : Noncopyable {
  public:
   explicit ScopedThreadHandle(HANDLE handle = NULL)
@@ -5,28 +5,40 @@
 #define ELOG_TIMER_H_
 
 #ifdef _WIN32
-# include "get_time_win.h"
+# include "get_time_win32.h"
 #else
 # include "get_time_posix.h"
 #endif
+#include "clock.h"
 
 namespace LOG {
 
-class Timer {
+// Measures the time elapsed since construction by ClockType.
+template <typename ClockType>
+class BasicTimer {
  public:
-  Timer()
-      : start_sec_(GetTimeSec()) {
+  BasicTimer()
+      : start_(ClockType::Now()) {
+  }
+
+  void Restart() {
+    start_ = ClockType::Now();
+  }
+
+  long long GetNanoSec() const {
+    return ClockType::ToNanoSec(ClockType::Now() - start_);
   }
 
   double GetTime() const {
-    const double now = GetTimeSec();
-    return now - start_sec_;
+    return GetNanoSec() * 1e-9;
   }
 
  private:
-  double start_sec_;
+  typename ClockType::Tick start_;
 };
 
+typedef BasicTimer<Clock> Timer;
+
 }  // namespace LOG
 
 #endif  // ELOG_TIMER_H_
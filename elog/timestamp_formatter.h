@@ -0,0 +1,83 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_TIMESTAMP_FORMATTER_H_
+#define ELOG_TIMESTAMP_FORMATTER_H_
+
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include "clock.h"
+
+namespace LOG {
+
+enum TimestampPrecision {
+  NO_TIMESTAMP,
+  TIMESTAMP_IN_SEC,       // [20110102 03:04:05]
+  TIMESTAMP_IN_MICRO_SEC  // [20110102 03:04:05.678901]
+};
+
+// Formats wall clock time in the local time zone. The date and time are
+// converted only when the second changes; otherwise the cached text is copied
+// and the microseconds are written over it. Not thread safe.
+class TimestampFormatter {
+ public:
+  // Enough for the text, a space and a terminating null.
+  static const std::size_t kMaxSize = 32;
+
+  TimestampFormatter()
+      : cached_sec_(-1) {
+    cached_text_[0] = '\0';
+  }
+
+  // Reads the clock and writes the timestamp followed by a space. Second
+  // precision uses the coarse clock. Returns the size written, which is zero
+  // for NO_TIMESTAMP.
+  std::size_t Format(TimestampPrecision precision, char* buffer) {
+    if (precision == NO_TIMESTAMP) return 0;
+    return Format(GetWallClockTime(precision == TIMESTAMP_IN_SEC),
+                  precision, buffer);
+  }
+
+  std::size_t Format(const WallClockTime& time,
+                     TimestampPrecision precision,
+                     char* buffer) {
+    if (precision == NO_TIMESTAMP) return 0;
+    if (time.sec != cached_sec_) {
+      FormatDateTime(time.sec);
+    }
+    // "[YYYYMMDD HH:MM:SS"
+    std::memcpy(buffer, cached_text_, kDateTimeSize);
+    char* itr = buffer + kDateTimeSize;
+    if (precision == TIMESTAMP_IN_MICRO_SEC) {
+      *itr++ = '.';
+      int micro_sec = time.micro_sec;
+      for (int i = 5; i >= 0; --i) {
+        itr[i] = static_cast<char>('0' + micro_sec % 10);
+        micro_sec /= 10;
+      }
+      itr += 6;
+    }
+    *itr++ = ']';
+    *itr++ = ' ';
+    *itr = '\0';
+    return itr - buffer;
+  }
+
+ private:
+  static const std::size_t kDateTimeSize = 18;
+
+  void FormatDateTime(long long sec) {
+    std::tm tm;
+    GetLocalTime(sec, tm);
+    std::strftime(cached_text_, sizeof(cached_text_), "[%Y%m%d %H:%M:%S", &tm);
+    cached_sec_ = sec;
+  }
+
+  long long cached_sec_;
+  char cached_text_[kMaxSize];
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_TIMESTAMP_FORMATTER_H_
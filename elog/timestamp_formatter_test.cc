@@ -0,0 +1,76 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <gtest/gtest.h>
+#include "timestamp_formatter.h"
+
+namespace LOG {
+
+namespace {
+
+std::string Format(TimestampFormatter& formatter,
+                   long long sec,
+                   int micro_sec,
+                   TimestampPrecision precision) {
+  const WallClockTime time = { sec, micro_sec };
+  char buffer[TimestampFormatter::kMaxSize];
+  const std::size_t size = formatter.Format(time, precision, buffer);
+  EXPECT_EQ(std::strlen(buffer), size);
+  return std::string(buffer, size);
+}
+
+std::string FormatByStrftime(long long sec) {
+  std::tm tm;
+  GetLocalTime(sec, tm);
+  char buffer[64];
+  std::strftime(buffer, sizeof(buffer), "[%Y%m%d %H:%M:%S", &tm);
+  return buffer;
+}
+
+TEST(TimestampFormatterTest, NoTimestamp) {
+  TimestampFormatter formatter;
+  char buffer[TimestampFormatter::kMaxSize];
+  EXPECT_EQ(0u, formatter.Format(NO_TIMESTAMP, buffer));
+}
+
+TEST(TimestampFormatterTest, Precision) {
+  static const long long kSec = 1300000000;
+  TimestampFormatter formatter;
+  const std::string date_time = FormatByStrftime(kSec);
+  EXPECT_EQ(date_time + "] ", Format(formatter, kSec, 7, TIMESTAMP_IN_SEC));
+  EXPECT_EQ(date_time + ".000007] ",
+            Format(formatter, kSec, 7, TIMESTAMP_IN_MICRO_SEC));
+  EXPECT_EQ(date_time + ".999999] ",
+            Format(formatter, kSec, 999999, TIMESTAMP_IN_MICRO_SEC));
+}
+
+TEST(TimestampFormatterTest, CacheIsUpdatedWhenSecondChanges) {
+  static const long long kSec = 1300000000;
+  TimestampFormatter formatter;
+  for (long long sec = kSec; sec < kSec + 100; sec += 7) {
+    EXPECT_EQ(FormatByStrftime(sec) + ".123456] ",
+              Format(formatter, sec, 123456, TIMESTAMP_IN_MICRO_SEC));
+    EXPECT_EQ(FormatByStrftime(sec) + ".654321] ",
+              Format(formatter, sec, 654321, TIMESTAMP_IN_MICRO_SEC));
+  }
+}
+
+TEST(TimestampFormatterTest, ReadsClock) {
+  TimestampFormatter formatter;
+  char buffer[TimestampFormatter::kMaxSize];
+  int date, hour, minute, sec, micro_sec;
+  formatter.Format(TIMESTAMP_IN_MICRO_SEC, buffer);
+  EXPECT_EQ(5, std::sscanf(buffer, "[%8d %2d:%2d:%2d.%6d] ",
+                           &date, &hour, &minute, &sec, &micro_sec));
+  formatter.Format(TIMESTAMP_IN_SEC, buffer);
+  EXPECT_EQ(4, std::sscanf(buffer, "[%8d %2d:%2d:%2d] ",
+                           &date, &hour, &minute, &sec));
+}
+
+}  // namespace
+
+}  // namespace LOG
@@ -6,18 +6,29 @@
 
 #include "config.h"
 
-#include <typeinfo>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#ifndef ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+# include <typeinfo>
+#endif
 #ifdef ELOG_I_USE_TR1_HEADER
 # include <tr1/functional>
 #else
 # include <functional>
 #endif
-#include "demangle.h"
+#include "atomic.h"
+#ifndef ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+# include "demangle.h"
+#endif
+#include "util.h"
 
 namespace LOG {
 
 template <typename T> class Type {};
 
+#ifndef ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+
 // Type name of T.
 // For each type T, the value of GlobalTypeName<T>::name as a pointer is
 // unique for all compilation units, even if addresses of typeid(T) are
@@ -30,27 +41,195 @@ struct GlobalTypeName {
 template <typename T>
 const char* GlobalTypeName<T>::name = typeid(T).name();
 
+// Key of T in TypeInfo and TypeNameTable.
+template <typename T>
+inline const void* GetTypeKey() {
+  return GlobalTypeName<T>::name;
+}
+
+// Mangled name.
+inline const char* GetRawTypeNameOfKey(const void* key) {
+  return static_cast<const char*>(key);
+}
+
+// Returns the mangled name if demangling fails.
+inline std::string GetTypeNameOfKey(const void* key) {
+  const Demangle demangle(GetRawTypeNameOfKey(key));
+  const char* const name = demangle.GetName();
+  return name ? name : GetRawTypeNameOfKey(key);
+}
+
+#else
+
+// Function whose pretty name contains the name of T. The address of
+// GlobalTypeName<T>::name is unique for all compilation units, and is known
+// at link time, so that neither RTTI nor a dynamic initializer is needed.
+// Cv-qualifiers and references are removed, as typeid() does.
+template <typename T>
+struct GlobalTypeName {
+  static const char* GetPrettyFunction() {
+    return ELOG_I_PRETTY_FUNCTION;
+  }
+
+  static const char* (*const name)();
+};
+
+template <typename T>
+const char* (*const GlobalTypeName<T>::name)() =
+    &GlobalTypeName<T>::GetPrettyFunction;
+
+template <typename T> struct TypeOfTypeId { typedef T type; };
+template <typename T> struct TypeOfTypeId<const T> { typedef T type; };
+template <typename T> struct TypeOfTypeId<volatile T> { typedef T type; };
+template <typename T> struct TypeOfTypeId<const volatile T> {
+  typedef T type;
+};
+template <typename T> struct TypeOfTypeId<T&> : TypeOfTypeId<T> {};
+
+template <typename T>
+inline const void* GetTypeKey() {
+  return &GlobalTypeName<typename TypeOfTypeId<T>::type>::name;
+}
+
+// Pretty name of the function.
+inline const char* GetRawTypeNameOfKey(const void* key) {
+  typedef const char* (*const GetPrettyFunction)();
+  return (*static_cast<const GetPrettyFunction*>(key))();
+}
+
+// Cuts T out of "... [with T = type]" of g++, "... [T = type]" of clang, or
+// "... GlobalTypeName<type>::GetPrettyFunction(void)" of MSVC. The type ends
+// at the ']' or ';' out of its own brackets, e.g. of "int [3]".
+inline std::string GetTypeNameOfKey(const void* key) {
+  const std::string pretty_function = GetRawTypeNameOfKey(key);
+  std::string::size_type with = pretty_function.find("[with T = ");
+  if (with != std::string::npos) {
+    with += sizeof("[with T = ") - 1;
+  } else if ((with = pretty_function.find("[T = ")) != std::string::npos) {
+    with += sizeof("[T = ") - 1;
+  }
+  if (with != std::string::npos) {
+    int depth = 0;
+    std::string::size_type end = with;
+    for (; end < pretty_function.size(); ++end) {
+      const char c = pretty_function[end];
+      if (c == '[') {
+        ++depth;
+      } else if ((c == ']' || c == ';') && depth == 0) {
+        break;
+      } else if (c == ']') {
+        --depth;
+      }
+    }
+    return pretty_function.substr(with, end - with);
+  }
+  const std::string::size_type begin = pretty_function.find('<');
+  const std::string::size_type end =
+      pretty_function.rfind(">::GetPrettyFunction");
+  if (begin != std::string::npos && end != std::string::npos && begin < end) {
+    return pretty_function.substr(begin + 1, end - begin - 1);
+  }
+  return pretty_function;
+}
+
+#endif
+
+// Insert-only table of type names keyed by GetTypeKey<T>(), so that each type
+// is named once in the process. Lookups do not lock; entries are published by
+// compare-and-swap and never freed.
+template <AvoidODR>
+class TypeNameTableTemplate {
+ public:
+  static const std::size_t kSize = 4096;  // power of 2
+
+  // Returns the raw name if the table is full.
+  static const char* GetName(const void* key) {
+    std::size_t index = Hash(key);
+    for (std::size_t i = 0; i < kSize; ++i, index = (index + 1) & (kSize - 1)) {
+      Entry* entry = entries_[index];
+      if (!entry) {
+        entry = Insert(index, key);
+        if (!entry) continue;  // taken by another type
+      }
+      if (entry->key == key) {
+        return entry->name;
+      }
+    }
+    return GetRawTypeNameOfKey(key);
+  }
+
+ private:
+  struct Entry {
+    const void* key;
+    const char* name;
+  };
+
+  static std::size_t Hash(const void* key) {
+    const std::size_t address = reinterpret_cast<std::size_t>(key);
+    return (address ^ address >> 12) & (kSize - 1);
+  }
+
+  // Returns the entry in the slot, or NULL if another thread has inserted
+  // another type there first.
+  static Entry* Insert(std::size_t index, const void* key) {
+    char* const name = CopyString(GetTypeNameOfKey(key));
+    Entry* const entry = new Entry;
+    entry->key = key;
+    entry->name = name;
+
+    Entry* const old_entry = static_cast<Entry*>(
+        CompareAndSwap(entries_[index], static_cast<Entry*>(NULL), entry));
+    if (!old_entry) {
+      return entry;
+    }
+    delete[] name;
+    delete entry;
+    return old_entry->key == key ? old_entry : NULL;
+  }
+
+  static char* CopyString(const std::string& s) {
+    char* const copy = new char[s.size() + 1];
+    std::memcpy(copy, s.c_str(), s.size() + 1);
+    return copy;
+  }
+
+  static Entry* volatile entries_[kSize];
+};
+
+template <AvoidODR N>
+typename TypeNameTableTemplate<N>::Entry* volatile
+TypeNameTableTemplate<N>::entries_[kSize];
+
+typedef TypeNameTableTemplate<AVOID_ODR> TypeNameTable;
+
 class TypeInfo {
  public:
   struct Hash : std::unary_function<TypeInfo, std::size_t> {
     std::size_t operator()(TypeInfo type_info) const {
-      return std::tr1::hash<const char*>()(type_info.global_type_name_);
+      return std::tr1::hash<const void*>()(type_info.key_);
     }
   };
 
   template <typename T>
   explicit TypeInfo(Type<T>)
-      : global_type_name_(GlobalTypeName<T>::name) {
+      : key_(GetTypeKey<T>()) {
   }
 
+#ifndef ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
   Demangle GetTypeName() const {
-    return Demangle(global_type_name_);
+    return Demangle(static_cast<const char*>(key_));
+  }
+#endif
+
+  // Name cached in TypeNameTable, which lives until the exit.
+  const char* GetName() const {
+    return TypeNameTable::GetName(key_);
   }
 
  private:
 #define ELOG_I_DEFINE_TYPEINFO_OPERATOR(op) \
   friend bool operator op(const TypeInfo& lhs, const TypeInfo& rhs) { \
-    return lhs.global_type_name_ op rhs.global_type_name_; \
+    return lhs.key_ op rhs.key_; \
   }
 
   ELOG_I_DEFINE_TYPEINFO_OPERATOR(==)
@@ -62,7 +241,7 @@ class TypeInfo {
 
 #undef ELOG_I_DEFINE_TYPEINFO_OPERATOR
 
-  const char* global_type_name_;
+  const void* key_;
 };
 
 }  // namespace LOG
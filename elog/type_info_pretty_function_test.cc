@@ -0,0 +1,68 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#define ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+
+#include <map>
+#include <string>
+#include <gtest/gtest.h>
+#include "type_info.h"
+
+namespace LOG {
+
+namespace {
+
+class UserDefinedTypeA {};
+class UserDefinedTypeB {};
+
+template <typename T> class Template {};
+
+}  // anonymous namespace
+
+TEST(TypeInfoPrettyFunctionTest, Equivalence) {
+  EXPECT_TRUE(TypeInfo(Type<int>()) == TypeInfo(Type<int>()));
+  EXPECT_TRUE(TypeInfo(Type<int>()) == TypeInfo(Type<const int>()));
+  EXPECT_TRUE(TypeInfo(Type<int>()) == TypeInfo(Type<const volatile int&>()));
+  EXPECT_FALSE(TypeInfo(Type<int>()) == TypeInfo(Type<const int*>()));
+  EXPECT_FALSE(TypeInfo(Type<int>()) == TypeInfo(Type<unsigned int>()));
+  EXPECT_FALSE(TypeInfo(Type<UserDefinedTypeA>()) ==
+               TypeInfo(Type<UserDefinedTypeB>()));
+}
+
+TEST(TypeInfoPrettyFunctionTest, Name) {
+  EXPECT_STREQ("int", TypeInfo(Type<int>()).GetName());
+  EXPECT_STREQ("int", TypeInfo(Type<const int>()).GetName());
+
+  const std::string name = TypeInfo(Type<UserDefinedTypeA>()).GetName();
+  EXPECT_NE(std::string::npos, name.find("UserDefinedTypeA"));
+  EXPECT_EQ(std::string::npos, name.find("GetPrettyFunction"));
+
+  const std::string template_name =
+      TypeInfo(Type<Template<std::map<int, char> > >()).GetName();
+  EXPECT_NE(std::string::npos, template_name.find("Template<"));
+  EXPECT_NE(std::string::npos, template_name.find("map<int, char"));
+  EXPECT_NE(']', *template_name.rbegin());
+}
+
+TEST(TypeInfoPrettyFunctionTest, ArrayName) {
+  const std::string array_name = TypeInfo(Type<int[3]>()).GetName();
+  EXPECT_EQ(0u, array_name.find("int"));
+  EXPECT_EQ("[3]", array_name.substr(array_name.size() - 3));
+
+  const std::string pointer_name = TypeInfo(Type<int(*)[3]>()).GetName();
+  EXPECT_EQ(0u, pointer_name.find("int"));
+  EXPECT_NE(std::string::npos, pointer_name.find("(*)"));
+  EXPECT_EQ("[3]", pointer_name.substr(pointer_name.size() - 3));
+
+  const std::string template_name =
+      TypeInfo(Type<Template<char[2]> >()).GetName();
+  EXPECT_NE(std::string::npos, template_name.find("Template<char"));
+  EXPECT_EQ('>', *template_name.rbegin());
+}
+
+TEST(TypeInfoPrettyFunctionTest, Cached) {
+  const TypeInfo type_info((Type<UserDefinedTypeA>()));
+  EXPECT_EQ(type_info.GetName(), type_info.GetName());
+}
+
+}  // namespace LOG
@@ -1,8 +1,18 @@
 // Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
 // This source code is distributed under MIT License in LICENSE file.
 
+#include "config.h"
+
+#include <string>
 #include <typeinfo>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/functional>
+#else
+# include <functional>
+#endif
 #include <gtest/gtest.h>
+#include "thread.h"
 #include "type_info.h"
 
 namespace LOG {
@@ -63,6 +73,14 @@ class TypeInfoTest : public ::testing::Test {
 class UserDefinedTypeA {};
 class UserDefinedTypeB {};
 
+template <int N> class Numbered {};
+
+void GetNames(const char** names) {
+  names[0] = TypeInfo(Type<Numbered<0> >()).GetName();
+  names[1] = TypeInfo(Type<Numbered<1> >()).GetName();
+  names[2] = TypeInfo(Type<Numbered<2> >()).GetName();
+}
+
 }  // anonymous namespace
 
 TEST_F(TypeInfoTest, CheckEquivalenceOfTypeInfosOfBuiltinTypes) {
@@ -94,4 +112,43 @@ TEST_F(TypeInfoTest, CheckEquivalenceOfUserDefinedTypes) {
   CheckEquivalenceOfTypeInfosInVariations<UserDefinedTypeA, UserDefinedTypeB>();
 }
 
+
+TEST(TypeNameTest, Demangled) {
+  const TypeInfo type_info((Type<UserDefinedTypeA>()));
+  const std::string name(type_info.GetName());
+  EXPECT_NE(std::string::npos, name.find("UserDefinedTypeA"));
+#ifndef ELOG_TYPE_NAME_FROM_PRETTY_FUNCTION
+  EXPECT_EQ(name, type_info.GetTypeName().GetName());
+#endif
+  EXPECT_STREQ("int", TypeInfo(Type<int>()).GetName());
+}
+
+TEST(TypeNameTest, Cached) {
+  const TypeInfo a((Type<UserDefinedTypeA>()));
+  const TypeInfo b((Type<UserDefinedTypeB>()));
+  EXPECT_EQ(a.GetName(), a.GetName());
+  EXPECT_NE(a.GetName(), b.GetName());
+  EXPECT_STRNE(a.GetName(), b.GetName());
+}
+
+TEST(TypeNameTest, SameInThreads) {
+  static const int kNumThreads = 8;
+  const char* names[kNumThreads][3];
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new Thread(std::tr1::bind(GetNames, names[i])));
+    threads.back()->Run();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_EQ(names[0][j], names[i][j]);
+    }
+  }
+  EXPECT_NE(std::string::npos, std::string(names[0][2]).find("Numbered<2>"));
+}
+
 }  // namespace LOG
@@ -0,0 +1,71 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+// Measures the headers of typed messages with the type name demangled at
+// every message, as Logger did, and with the name cached in TypeNameTable,
+// and the throughput of StreamLogger::PushTypedMessage.
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include "logger.h"
+#include "message_stream.h"
+#include "stream_logger.h"
+#include "timer.h"
+#include "type_info.h"
+
+namespace {
+
+const int kNumIterations = 1000000;
+
+template <typename T> class SomeModule {};
+
+void PrintThroughput(const char* title, double time) {
+  std::cout << title << ": " << kNumIterations / time << " messages/sec ("
+            << time * 1e9 / kNumIterations << " ns/message)" << std::endl;
+}
+
+}  // anonymous namespace
+
+int main() {
+  const LOG::TypeInfo type_info(
+      (LOG::Type<SomeModule<std::map<std::string, int> > >()));
+  std::size_t total_size = 0;
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG::MessageStream stream;
+      const LOG::Demangle demangle = type_info.GetTypeName();
+      stream << "[" << demangle.GetName() << "(" << 1 << ")] ";
+      total_size += stream.size();
+    }
+    PrintThroughput("header demangled at every message", timer.GetTime());
+  }
+  {
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      LOG::MessageStream stream;
+      LOG::Logger::OutputTypedMessageHeader(type_info, 1, stream);
+      total_size += stream.size();
+    }
+    PrintThroughput("header with the cached name", timer.GetTime());
+  }
+  {
+    std::ostringstream output;
+    LOG::StreamLogger logger(output);
+    logger.SetTypeVerbosity(type_info, 1);
+    const std::string message = "message";
+    LOG::Timer timer;
+    for (int i = 0; i < kNumIterations; ++i) {
+      logger.PushTypedMessage(type_info, 1, __FILE__, __LINE__, message);
+      if (i % 1000 == 999) {
+        total_size += output.str().size();
+        output.str("");
+      }
+    }
+    PrintThroughput("StreamLogger::PushTypedMessage", timer.GetTime());
+  }
+  return total_size == 0;
+}
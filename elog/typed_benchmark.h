@@ -4,11 +4,21 @@
 #ifndef ELOG_TYPED_BENCHMARK_H_
 #define ELOG_TYPED_BENCHMARK_H_
 
+#include "config.h"
+
+#include <cstddef>
 #include <string>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/memory>
+#else
+# include <memory>
+#endif
 #include "benchmark_suite.h"
+#include "benchmark_trace.h"
+#include "clock.h"
 #include "elog.h"
+#include "perf_counters.h"
 #include "safe_bool.h"
-#include "timer.h"
 #include "type_info.h"
 #include "typed_log.h"
 
@@ -16,27 +26,71 @@ namespace LOG {
 
 class TypedBenchmark : public SafeBool<TypedBenchmark> {
  public:
+  // Inactive benchmark, which measures and prints nothing.
+  TypedBenchmark()
+      : type_info_(Type<void>()),
+        verbosity_(0),
+        source_file_name_(NULL),
+        line_number_(0),
+        logger_(NULL),
+        start_time_(),
+        suite_(NULL),
+        case_id_(0),
+        traced_(false),
+        logged_(false),
+        done_(true) {
+  }
+
+  // Same as ScopedBenchmark, the messages are not built if the logger
+  // discards them.
   TypedBenchmark(const std::string& title,
                  TypeInfo type_info,
                  const char* source_file_name,
                  int line_number,
                  int verbosity = 0,
                  BenchmarkSuite* suite = NULL,
-                 Logger* logger = NULL)
-      : typed_log_(type_info, verbosity, source_file_name, line_number, logger),
-        title_(title),
+                 Logger* logger = NULL,
+                 BenchmarkCaseSite* case_site = NULL)
+      : title_(title),
+        type_info_(type_info),
+        verbosity_(verbosity),
+        source_file_name_(source_file_name),
+        line_number_(line_number),
+        logger_(logger),
+        perf_counters_(IsPerfCountersEnabled() ? new PerfCounters : NULL),
+        start_time_(Clock::Now()),
         suite_(suite),
+        case_id_(0),
+        traced_(IsBenchmarkTraceEnabled()),
+        logged_(IsLogged(type_info, verbosity, logger)),
         done_(false) {
-    TypedLog start_log(type_info, verbosity,
-                       source_file_name, line_number, logger);
-    start_log << title << ": start...";
-    start_log.PushMessage();
+    if (suite_) {
+      case_id_ = suite_->EnterScope(case_site, title);
+    }
+    if (logged_) {
+      TypedLog start_log(type_info, verbosity,
+                         source_file_name, line_number, logger);
+      start_log << title << ": start...";
+      start_log.PushMessage();
+    }
+    if (traced_) {
+      BeginBenchmarkTrace(title_);
+    }
   }
 
   TypedBenchmark(const TypedBenchmark& typed_benchmark)
-      : typed_log_(typed_benchmark.typed_log_),
-        title_(typed_benchmark.title_),
+      : title_(typed_benchmark.title_),
+        type_info_(typed_benchmark.type_info_),
+        verbosity_(typed_benchmark.verbosity_),
+        source_file_name_(typed_benchmark.source_file_name_),
+        line_number_(typed_benchmark.line_number_),
+        logger_(typed_benchmark.logger_),
+        perf_counters_(typed_benchmark.perf_counters_),
+        start_time_(typed_benchmark.start_time_),
         suite_(typed_benchmark.suite_),
+        case_id_(typed_benchmark.case_id_),
+        traced_(typed_benchmark.traced_),
+        logged_(typed_benchmark.logged_),
         done_(typed_benchmark.done_) {
   }
 
@@ -48,8 +102,10 @@ class TypedBenchmark : public SafeBool<TypedBenchmark> {
     return false;
   }
 
+  // Zero if inactive.
   double GetTime() const {
-    return timer_.GetTime();
+    return source_file_name_ ?
+        Clock::ToNanoSec(Clock::Now() - start_time_) * 1e-9 : 0;
   }
 
   void Print() {
@@ -60,19 +116,52 @@ class TypedBenchmark : public SafeBool<TypedBenchmark> {
   }
 
  private:
+  static bool IsLogged(TypeInfo type_info, int verbosity, Logger* logger) {
+    return ELOG_I_IS_VERBOSITY_COMPILED_IN(verbosity) &&
+        !IsVerboseEnough(
+            verbosity,
+            (logger ? *logger : GetLogger()).GetTypeVerbosity(type_info));
+  }
+
   void PrintWithoutCheck() {
-    const double time = timer_.GetTime();
+    const double time = GetTime();
+    PerfCounterValues perf_counter_values;
+    const bool has_perf_counters =
+        perf_counters_ && perf_counters_->IsAvailable();
+    if (has_perf_counters) {
+      perf_counters_->GetDeltas(perf_counter_values);
+    }
+    if (traced_) {
+      EndBenchmarkTrace(title_);
+    }
     if (suite_) {
-      suite_->AddCase(title_, time);
+      suite_->ExitScope(case_id_, time,
+                        has_perf_counters ? &perf_counter_values : NULL);
+    }
+    if (!logged_) return;
+    TypedLog end_log(type_info_, verbosity_,
+                     source_file_name_, line_number_, logger_);
+    end_log << title_ << ": " << time << " sec";
+    if (has_perf_counters) {
+      end_log << " (";
+      PrintPerfCounterValues(perf_counter_values, end_log);
+      end_log << ')';
     }
-    typed_log_ << title_ << ": " << time << " sec";
-    typed_log_.PushMessage();
+    end_log.PushMessage();
   }
 
-  TypedLog typed_log_;
   std::string title_;
-  Timer timer_;
+  TypeInfo type_info_;
+  int verbosity_;
+  const char* source_file_name_;
+  int line_number_;
+  Logger* logger_;
+  std::tr1::shared_ptr<PerfCounters> perf_counters_;  // opened before start
+  Clock::Tick start_time_;
   BenchmarkSuite* suite_;
+  std::size_t case_id_;
+  bool traced_;
+  bool logged_;
 
   bool done_;
 };
@@ -5,15 +5,46 @@
 #define ELOG_TYPED_LOG_H_
 
 #include <cstddef>
-#include <sstream>
 #include <string>
 #include "logger.h"
+#include "atomic.h"
+#include "log_site.h"
 #include "logger_factory.h"
+#include "message_stream.h"
 #include "put_as_string.h"
 #include "type_info.h"
 
 namespace LOG {
 
+// Returns whether the current logger writes LOG(type, verbosity) at the site.
+// The verbosity of the type is looked up only when the site runs for the
+// first time or after the log settings have changed.
+inline bool IsTypedLogEnabled(TypedLogSite& site,
+                              int verbosity,
+                              const char* source_file_name,
+                              int line_number) {
+  const std::size_t generation = GetLogGeneration();
+  const std::size_t cached_generation = site.generation;
+  if (cached_generation == generation) {
+    return !IsVerboseEnough(verbosity, site.type_verbosity);
+  }
+
+  RegisterTypedLogSite(site, verbosity, source_file_name, line_number);
+  const int type_verbosity =
+      GetLogger().GetTypeVerbosity(site.get_type_info());
+  // Only the thread which claims the site stores the pair, so that a
+  // verbosity looked up under an older generation never overwrites a newer
+  // one. Other threads use their own lookup without caching it.
+  if (cached_generation != kRefreshingLogSite &&
+      CompareAndSwap(site.generation, cached_generation,
+                     kRefreshingLogSite) == cached_generation) {
+    site.type_verbosity = type_verbosity;
+    AtomicFence();
+    site.generation = generation;
+  }
+  return !IsVerboseEnough(verbosity, type_verbosity);
+}
+
 class TypedLog {
  public:
   TypedLog(TypeInfo type_info,
@@ -48,12 +79,13 @@ class TypedLog {
 
   void PushMessage() const {
     logger_.PushTypedMessage(type_info_, verbosity_,
-                             source_file_name_, line_number_, stream_.str());
+                             source_file_name_, line_number_,
+                             stream_.data(), stream_.size());
   }
 
  private:
   Logger& logger_;
-  std::ostringstream stream_;
+  MessageStream stream_;
   TypeInfo type_info_;
   int verbosity_;
   const char* source_file_name_;
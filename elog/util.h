@@ -58,10 +58,29 @@ class IsContainer {
       sizeof(HasConstIterator<T>(0)) == sizeof(TrueType);
 };
 
+// Whether T declares size() itself; one inherited from a base class is not
+// detected.
+template <typename T>
+class HasSize {
+ private:
+  template <typename Type, typename Type::size_type (Type::*)() const>
+  struct SizeMember {};
+
+  template <typename Type>
+  static TrueType HasSizeMember(SizeMember<Type, &Type::size>*);
+
+  template <typename Type>
+  static FalseType HasSizeMember(...);
+
+ public:
+  static const bool value = sizeof(HasSizeMember<T>(0)) == sizeof(TrueType);
+};
+
 }  // namespace LOG
 
 // #include <vector>
 // static int v[LOG::IsContainer<std::vector<int> >::value ? 1 : -1];
 // static int w[LOG::IsContainer<char>::value ? -1 : 1];
+// static int x[LOG::HasSize<std::vector<int> >::value ? 1 : -1];
 
 #endif  // ELOG_UTIL_H_
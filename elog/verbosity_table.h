@@ -0,0 +1,79 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#ifndef ELOG_VERBOSITY_TABLE_H_
+#define ELOG_VERBOSITY_TABLE_H_
+
+#include "config.h"
+
+#include <algorithm>
+#include <vector>
+#ifdef ELOG_I_USE_TR1_HEADER
+# include <tr1/unordered_map>
+#else
+# include <unordered_map>
+#endif
+#include "atomic.h"
+#include "log_site.h"
+#include "mutex.h"
+#include "type_info.h"
+#include "util.h"
+
+namespace LOG {
+
+// Map from types to verbosities, optimized for lookups from many threads.
+// Readers load the current snapshot of the map with a single pointer read and
+// never lock. Writers copy the snapshot, modify the copy and publish it.
+// Replaced snapshots are kept until the table is destroyed, because readers
+// may still be looking at them; writes are expected to be rare. Each write
+// invalidates the verbosities cached by log sites.
+class VerbosityTable : Noncopyable {
+ public:
+  VerbosityTable()
+      : map_(new Map) {
+  }
+
+  ~VerbosityTable() {
+    std::for_each(retired_maps_.begin(), retired_maps_.end(),
+                  CheckedDelete<Map>);
+    delete map_;
+  }
+
+  // Returns 0 for types whose verbosity has not been set.
+  int Get(TypeInfo type_info) const {
+    const Map* map = map_;
+    const Map::const_iterator itr = map->find(type_info);
+    return itr == map->end() ? 0 : itr->second;
+  }
+
+  void Set(TypeInfo type_info, int verbosity) {
+    MutexLock lock(mutex_);
+    Map* map = new Map(*map_);
+    (*map)[type_info] = verbosity;
+    Publish(map);
+  }
+
+  void Clear() {
+    MutexLock lock(mutex_);
+    Publish(new Map);
+  }
+
+ private:
+  typedef std::tr1::unordered_map<TypeInfo, int, TypeInfo::Hash> Map;
+
+  void Publish(Map* map) {
+    Map* const old_map = map_;
+    retired_maps_.push_back(old_map);
+    AtomicFence();
+    AtomicSet(map_, map);
+    InvalidateLogSites();
+  }
+
+  Map* volatile map_;
+  std::vector<Map*> retired_maps_;
+  Mutex mutex_;
+};
+
+}  // namespace LOG
+
+#endif  // ELOG_VERBOSITY_TABLE_H_
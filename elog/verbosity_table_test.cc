@@ -0,0 +1,44 @@
+// Copyright (c) 2011 Seiya Tokui <beam.web@gmail.com>. All Rights Reserved.
+// This source code is distributed under MIT License in LICENSE file.
+
+#include <gtest/gtest.h>
+#include "verbosity_table.h"
+
+namespace LOG {
+
+namespace {
+
+class SomeModule {};
+class AnotherModule {};
+
+}  // anonymous namespace
+
+TEST(VerbosityTableTest, DefaultVerbosity) {
+  VerbosityTable table;
+  EXPECT_EQ(0, table.Get(TypeInfo(Type<SomeModule>())));
+}
+
+TEST(VerbosityTableTest, Set) {
+  VerbosityTable table;
+  table.Set(TypeInfo(Type<SomeModule>()), 3);
+  EXPECT_EQ(3, table.Get(TypeInfo(Type<SomeModule>())));
+  EXPECT_EQ(0, table.Get(TypeInfo(Type<AnotherModule>())));
+}
+
+TEST(VerbosityTableTest, Overwrite) {
+  VerbosityTable table;
+  table.Set(TypeInfo(Type<SomeModule>()), 3);
+  table.Set(TypeInfo(Type<AnotherModule>()), 1);
+  table.Set(TypeInfo(Type<SomeModule>()), 2);
+  EXPECT_EQ(2, table.Get(TypeInfo(Type<SomeModule>())));
+  EXPECT_EQ(1, table.Get(TypeInfo(Type<AnotherModule>())));
+}
+
+TEST(VerbosityTableTest, Clear) {
+  VerbosityTable table;
+  table.Set(TypeInfo(Type<SomeModule>()), 3);
+  table.Clear();
+  EXPECT_EQ(0, table.Get(TypeInfo(Type<SomeModule>())));
+}
+
+}  // namespace LOG
@@ -13,6 +13,12 @@
 #include <type_traits>
 #include <utility>
 
+#ifdef _MSC_VER
+# define ELOG_THREAD_LOCAL __declspec(thread)
+#else
+# define ELOG_THREAD_LOCAL __thread
+#endif
+
 namespace LOG
 {
 
@@ -197,20 +203,47 @@ print_arguments(Stream& stream, const T& t, Args... args)
 }
 
 
-// get current datetime
-inline std::tm
-get_tm()
+// local datetime of timeval
+// localtime is called only when the second changes.
+inline const std::tm&
+get_cached_tm(std::time_t timeval)
 {
-  auto timeval = std::time(nullptr);
-  std::tm tm;
+  static ELOG_THREAD_LOCAL std::time_t cached_timeval = -1;
+  static ELOG_THREAD_LOCAL std::tm cached_tm;
 
+  if (timeval != cached_timeval) {
 #ifdef _WIN32
-  localtime_s(&tm, &timeval);
+    localtime_s(&cached_tm, &timeval);
 #else
-  localtime_r(&timeval, &tm);
+    localtime_r(&timeval, &cached_tm);
 #endif
+    cached_timeval = timeval;
+  }
 
-  return tm;
+  return cached_tm;
+}
+
+// get current datetime
+inline std::tm
+get_tm()
+{ return get_cached_tm(std::time(nullptr)); }
+
+// "[%Y%m%d %X] " of current datetime
+// strftime is called only when the second changes.
+inline const char*
+get_time_prefix()
+{
+  static ELOG_THREAD_LOCAL std::time_t cached_timeval = -1;
+  static ELOG_THREAD_LOCAL char cached_prefix[64];
+
+  auto timeval = std::time(nullptr);
+  if (timeval != cached_timeval) {
+    std::strftime(cached_prefix, sizeof(cached_prefix), "[%Y%m%d %X] ",
+                  &get_cached_tm(timeval));
+    cached_timeval = timeval;
+  }
+
+  return cached_prefix;
 }
 
 
@@ -243,12 +276,7 @@ struct stream_logger
   void
   write(const std::string& message) const
   {
-    auto tm = get_tm();
-
-    char buffer[64];
-    std::strftime(buffer, sizeof(buffer), "[%Y%m%d %X] ", &tm);
-
-    (*os_) << buffer << message << std::endl;
+    (*os_) << get_time_prefix() << message << std::endl;
   }
 
  private: